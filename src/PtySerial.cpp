@@ -0,0 +1,110 @@
+#include "PtySerial.hpp"
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+PtySerial::~PtySerial() {
+    end();
+}
+
+/// open the pseudo terminal (raw mode) and start the reader thread
+bool PtySerial::begin() {
+    if (_running) return true;
+    _master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (_master < 0) return false;
+    if (grantpt(_master) != 0 || unlockpt(_master) != 0 || ptsname_r(_master, _slave_name, sizeof(_slave_name)) != 0) {
+        end();
+        return false;
+    }
+    _slave = open(_slave_name, O_RDWR | O_NOCTTY);
+    if (_slave < 0) {
+        end();
+        return false;
+    }
+    struct termios tio;
+    tcgetattr(_slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(_slave, TCSANOW, &tio);
+    _running = true;
+    _reader = std::thread(&PtySerial::readerTask, this);
+    return true;
+}
+
+void PtySerial::end() {
+    _running = false;
+    if (_reader.joinable()) _reader.join();
+    if (_slave >= 0) close(_slave);
+    if (_master >= 0) close(_master);
+    _slave = -1;
+    _master = -1;
+}
+
+/// callback on each received block, it runs on the reader thread
+void PtySerial::onReceive(std::function<void(void)> callback) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _callback = callback;
+}
+
+int PtySerial::available() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (_head + PTY_RX_BUFFER - _tail) % PTY_RX_BUFFER;
+}
+
+int PtySerial::read() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_head == _tail) return -1;
+    uint8_t c = _buf[_tail];
+    _tail = (_tail + 1) % PTY_RX_BUFFER;
+    return c;
+}
+
+int PtySerial::peek() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _head == _tail ? -1 : _buf[_tail];
+}
+
+void PtySerial::flush() {
+    if (_master >= 0) tcdrain(_master);
+}
+
+size_t PtySerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t PtySerial::write(const uint8_t *buffer, size_t size) {
+    if (_master < 0) return 0;
+    ssize_t n = ::write(_master, buffer, size);
+    return n < 0 ? 0 : n;
+}
+
+/// blocking reads (with a poll timeout to stop) to the RX ring buffer
+void PtySerial::readerTask() {
+    uint8_t chunk[64];
+    struct pollfd pfd = {_master, POLLIN, 0};
+    while (_running) {
+        if (poll(&pfd, 1, 100) <= 0) continue;
+        ssize_t n = ::read(_master, chunk, sizeof(chunk));
+        if (n <= 0) continue;
+        std::function<void(void)> callback;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (ssize_t i = 0; i < n; i++) {
+                size_t next = (_head + 1) % PTY_RX_BUFFER;
+                if (next == _tail) {
+                    _overflows++;
+                    continue;
+                }
+                _buf[_head] = chunk[i];
+                _head = next;
+            }
+            callback = _callback;
+        }
+        if (callback) callback();
+    }
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef PtySerial_hpp
+#define PtySerial_hpp
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <Arduino.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#define PTY_RX_BUFFER 256  // RX ring buffer (bytes)
+
+/**
+ * Host backend of a sensor UART on a Linux pseudo terminal, for tests and
+ * benchmarks without hardware. A simulator writes the sensor frames on the
+ * slave side (see slaveName()). A blocking reader thread fills the RX ring
+ * buffer and calls the receive callback, like the ESP32 UART events.
+ */
+class PtySerial : public Stream {
+   public:
+    ~PtySerial();
+
+    bool begin();
+
+    void end();
+
+    const char *slaveName() const { return _slave_name; }
+
+    void onReceive(std::function<void(void)> callback);
+
+    int available();
+
+    int read();
+
+    int peek();
+
+    void flush();
+
+    size_t write(uint8_t c);
+
+    size_t write(const uint8_t *buffer, size_t size);
+
+    // bytes lost by a full RX buffer
+    uint32_t overflows() const { return _overflows; }
+
+   private:
+    int _master = -1;
+    int _slave = -1;  // kept open, the master doesn't hang up without simulator
+    char _slave_name[64] = "";
+    std::thread _reader;
+    std::atomic<bool> _running{false};
+    std::mutex _mutex;
+    std::function<void(void)> _callback;
+    uint8_t _buf[PTY_RX_BUFFER];
+    size_t _head = 0;
+    size_t _tail = 0;
+    uint32_t _overflows = 0;
+
+    void readerTask();
+};
+
+#endif
+#endif
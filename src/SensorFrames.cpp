@@ -0,0 +1,251 @@
+#include "SensorFrames.hpp"
+
+const uint8_t mhz19_read_cmd[9] = {0xFF, 0x01, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x79};
+const uint8_t cm1106_read_cmd[4] = {0x11, 0x01, 0x01, 0xED};
+const uint8_t s8_read_cmd[8] = {0xFE, 0x04, 0x00, 0x03, 0x00, 0x01, 0xD5, 0xC5};
+const uint8_t shdlc_info_cmd[7] = {0x7E, 0x00, 0xD0, 0x01, 0x00, 0x2E, 0x7E};  // SPS30 product type
+
+FrameMatcher::FrameMatcher(FRAME_TYPE type) : _type(type) {}
+
+void FrameMatcher::reset() {
+    _pos = 0;
+    _len = 0;
+    _escape = false;
+}
+
+/**
+ * Push one byte of the UART stream.
+ * @return true when a complete frame is validated, see frame() and length()
+ */
+bool FrameMatcher::push(uint8_t c) {
+    if (_type == FRAME_SHDLC) return pushSHDLC(c);
+    if (_pos < 2 && !isHeader(_pos, c)) {
+        _pos = 0;
+        if (!isHeader(0, c)) return false;  // maybe it is the start of the next frame
+    }
+    _buf[_pos++] = c;
+    uint8_t len = frameLength();
+    if (len == 0) {  // invalid length field
+        _errors++;
+        _pos = 0;
+        return false;
+    }
+    if (_pos < len) return false;
+    _pos = 0;
+    if (!isValid(len)) {
+        _errors++;
+        return false;
+    }
+    _len = len;
+    return true;
+}
+
+/**
+ * Sensirion SHDLC frames (SPS30), delimited by 0x7E with byte stuffing.
+ * MISO content: address, command, state, length, data and checksum.
+ */
+bool FrameMatcher::pushSHDLC(uint8_t c) {
+    if (c == 0x7E) {
+        bool valid = _pos >= 5 && _pos == _buf[3] + 5 && isValid(_pos);
+        if (_pos >= 5 && !valid) _errors++;
+        if (valid) _len = _pos;
+        _pos = 0;
+        _escape = false;
+        return valid;
+    }
+    if (c == 0x7D) {
+        _escape = true;
+        return false;
+    }
+    if (_escape) c ^= 0x20;
+    _escape = false;
+    if (_pos >= FRAME_MAX_LENGTH) _pos = 0;  // no delimiter, wait for the next one
+    _buf[_pos++] = c;
+    return false;
+}
+
+bool FrameMatcher::isHeader(uint8_t pos, uint8_t c) {
+    switch (_type) {
+        case FRAME_PMS:
+            return pos == 0 ? c == 0x42 : c == 0x4D;
+        case FRAME_PANASONIC:
+            return pos == 0 ? c == 0x02 : true;
+        case FRAME_SDS011:
+            return pos == 0 ? c == 0xAA : c == 0xC0;
+        case FRAME_MHZ19:
+            return pos == 0 ? c == 0xFF : c == 0x86;
+        case FRAME_CM1106:
+            return pos == 0 ? c == 0x16 : c == 0x05;
+        case FRAME_S8:
+            return pos == 0 ? c == 0xFE : c == 0x04;
+        default:
+            return false;
+    }
+}
+
+/// expected length of the current frame, 0 if the length field is wrong
+uint8_t FrameMatcher::frameLength() {
+    switch (_type) {
+        case FRAME_PMS: {
+            if (_pos < 4) return FRAME_MAX_LENGTH;
+            uint16_t len = (_buf[2] << 8 | _buf[3]) + 4;
+            return (len < 8 || len > FRAME_MAX_LENGTH) ? 0 : len;
+        }
+        case FRAME_PANASONIC:
+            return 32;
+        case FRAME_SDS011:
+            return 10;
+        case FRAME_MHZ19:
+            return 9;
+        case FRAME_CM1106:
+            return 8;
+        case FRAME_S8:
+            if (_pos < 3) return FRAME_MAX_LENGTH;
+            return _buf[2] == 0x02 ? 7 : 0;
+        default:
+            return 0;
+    }
+}
+
+/// checksum of a complete frame of the given length (its length field on PMS)
+bool FrameMatcher::isValid(uint8_t len) {
+    uint16_t sum = 0;
+    switch (_type) {
+        case FRAME_PMS:
+            for (int i = 0; i < len - 2; i++) sum += _buf[i];
+            return sum == (_buf[len - 2] << 8 | _buf[len - 1]);
+        case FRAME_PANASONIC: {
+            uint8_t fcc = 0;
+            for (int i = 1; i < 30; i++) fcc ^= _buf[i];
+            return fcc == _buf[30] && _buf[31] == 0x03;
+        }
+        case FRAME_SDS011:
+            for (int i = 2; i < 8; i++) sum += _buf[i];
+            return (sum & 0xFF) == _buf[8] && _buf[9] == 0xAB;
+        case FRAME_MHZ19:
+            for (int i = 1; i < 8; i++) sum += _buf[i];
+            return (uint8_t)(0xFF - sum + 1) == _buf[8];
+        case FRAME_CM1106:
+            for (int i = 0; i < 8; i++) sum += _buf[i];
+            return (sum & 0xFF) == 0;
+        case FRAME_S8:
+            return modbusCRC(_buf, 5) == (_buf[5] | _buf[6] << 8);
+        case FRAME_SHDLC:
+            for (int i = 0; i < len - 1; i++) sum += _buf[i];
+            return (uint8_t)~sum == _buf[len - 1];
+        default:
+            return false;
+    }
+}
+
+FrameDetector::FrameDetector() {
+    for (int i = 0; i <= FRAME_S8 - FRAME_PMS; i++) _matchers[i] = FrameMatcher((FRAME_TYPE)(FRAME_PMS + i));
+}
+
+FRAME_TYPE FrameDetector::push(uint8_t c) {
+    for (int i = 0; i <= FRAME_S8 - FRAME_PMS; i++) {
+        if (_matchers[i].push(c)) return _matchers[i].type();
+    }
+    return FRAME_NONE;
+}
+
+/**
+ * Decode of one validated frame of the UART sensors (main and extra ones).
+ * @return false if the readings are out of range: PM2.5 and PM10 over 1000
+ * (over 2000 on Panasonic), or CO2 of zero (sensor warming up)
+ */
+bool frameDecode(FRAME_TYPE type, const uint8_t *frame, uint8_t length, FrameValues *values) {
+    memset(values, 0, sizeof(FrameValues));
+    switch (type) {
+        case FRAME_PMS: {
+            uint16_t data[FRAME_MAX_LENGTH / 2];  // big endian words
+            for (int i = 0; i < length / 2; i++) data[i] = frame[i * 2] << 8 | frame[i * 2 + 1];
+            values->has_pm = true;
+            values->pm25 = data[3];
+            values->pm10 = data[4];
+            // Plantower 32 bytes frame has a version byte, on Honeywell those are reserved (zero)
+            if (length == 32 && frame[28] != 0) {
+                values->has_pm1 = true;
+                values->has_extended = true;
+                values->pm1 = data[2];
+                values->pm1a = data[5];
+                values->pm25a = data[6];
+                values->pm10a = data[7];
+                values->cnt03 = data[8];
+                values->cnt05 = data[9];
+                values->cnt1 = data[10];
+                values->cnt25 = data[11];
+                values->cnt5 = data[12];
+                values->cnt10 = data[13];
+            }
+            return !(values->pm25 > 1000 && values->pm10 > 1000);
+        }
+        case FRAME_PANASONIC:
+            values->has_pm = true;
+            values->has_pm1 = true;
+            values->pm1 = frame[2] << 8 | frame[1];
+            values->pm25 = frame[6] << 8 | frame[5];
+            values->pm10 = frame[10] << 8 | frame[9];
+            return !(values->pm25 > 2000 && values->pm10 > 2000);
+        case FRAME_SDS011:
+            values->has_pm = true;
+            values->pm25 = (frame[3] << 8 | frame[2]) / 10;
+            values->pm10 = (frame[5] << 8 | frame[4]) / 10;
+            return !(values->pm25 > 1000 && values->pm10 > 1000);
+        case FRAME_MHZ19:
+        case FRAME_CM1106:
+        case FRAME_S8:
+            values->has_co2 = true;
+            values->co2 = type == FRAME_MHZ19 ? frame[2] << 8 | frame[3] : frame[3] << 8 | frame[4];
+            if (type == FRAME_MHZ19) {
+                values->has_temperature = true;
+                values->temperature = frame[4] - 40;
+            }
+            return values->co2 != 0;
+        default:
+            return false;
+    }
+}
+
+uint16_t modbusCRC(const uint8_t *data, uint8_t length) {
+    uint16_t crc = 0xFFFF;
+    for (int i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
+
+/// Sensirion I2C CRC-8 (polynomial 0x31, init 0xFF) of each data word
+uint8_t sensirionCRC(const uint8_t *data, uint8_t length) {
+    uint8_t crc = 0xFF;
+    for (int i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+/**
+ * Score of a recorded UART byte stream, used for baud rate and framing
+ * detection. Each valid frame scores 4 points and each frame with right
+ * header but wrong checksum 1 point, only on frame types with one valid
+ * frame at least (headers alone are found on garbled streams).
+ * @param best optional, frame type with the highest score
+ * @return score of the best frame type, 0 without valid frames
+ */
+int frameScore(const uint8_t *data, size_t length, FRAME_TYPE *best) {
+    int best_score = 0;
+    if (best != nullptr) *best = FRAME_NONE;
+    for (int type = FRAME_PMS; type <= FRAME_SHDLC; type++) {
+        FrameMatcher matcher((FRAME_TYPE)type);
+        int valid = 0;
+        for (size_t i = 0; i < length; i++) valid += matcher.push(data[i]);
+        int score = valid > 0 ? valid * 4 + matcher.errors() : 0;
+        if (score > best_score) {
+            best_score = score;
+            if (best != nullptr) *best = (FRAME_TYPE)type;
+        }
+    }
+    return best_score;
+}
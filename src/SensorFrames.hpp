@@ -0,0 +1,97 @@
+#ifndef SensorFrames_hpp
+#define SensorFrames_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Max frame length of the UART sensors supported (Plantower and Panasonic)
+#define FRAME_MAX_LENGTH 32
+
+// UART frames supported by the incremental matchers
+enum FRAME_TYPE { FRAME_NONE, FRAME_PMS, FRAME_PANASONIC, FRAME_SDS011, FRAME_MHZ19, FRAME_CM1106, FRAME_S8, FRAME_SHDLC };
+
+// Probe commands for CO2 sensors (read CO2 request)
+extern const uint8_t mhz19_read_cmd[9];
+extern const uint8_t cm1106_read_cmd[4];
+extern const uint8_t s8_read_cmd[8];
+extern const uint8_t shdlc_info_cmd[7];
+
+/**
+ * Incremental frame matcher. Bytes are pushed one by one from the UART
+ * stream and it returns true when a complete frame with valid header
+ * and checksum is found. It resyncs on the next header after errors.
+ */
+class FrameMatcher {
+   public:
+    explicit FrameMatcher(FRAME_TYPE type = FRAME_NONE);
+
+    bool push(uint8_t c);
+
+    void reset();
+
+    FRAME_TYPE type() const { return _type; }
+
+    const uint8_t *frame() const { return _buf; }
+
+    uint8_t length() const { return _len; }
+
+    // frames with a right header but wrong checksum
+    uint16_t errors() const { return _errors; }
+
+   private:
+    FRAME_TYPE _type;
+    uint8_t _buf[FRAME_MAX_LENGTH];
+    uint8_t _pos = 0;
+    uint8_t _len = 0;
+    uint16_t _errors = 0;
+    bool _escape = false;
+
+    bool pushSHDLC(uint8_t c);
+    bool isHeader(uint8_t pos, uint8_t c);
+    uint8_t frameLength();
+    bool isValid(uint8_t len);
+};
+
+/**
+ * Concurrent detection of the UART sensors: the frame matchers of all
+ * sensors (without SHDLC) run in parallel over the same byte stream, and
+ * the first valid frame (header and checksum) wins.
+ */
+class FrameDetector {
+   public:
+    FrameDetector();
+
+    // frame type of the first valid frame, FRAME_NONE until then
+    FRAME_TYPE push(uint8_t c);
+
+   private:
+    FrameMatcher _matchers[FRAME_S8 - FRAME_PMS + 1];
+};
+
+/**
+ * Readings of one validated UART frame (see frameDecode). Plantower frames
+ * have the atmospheric PM and the particle counts, MH-Z19 the temperature.
+ */
+typedef struct FrameValues {
+    bool has_pm;           // pm25 and pm10
+    bool has_pm1;          // Panasonic and Plantower
+    bool has_extended;     // atmospheric PM and counts (Plantower)
+    bool has_co2;
+    bool has_temperature;  // MH-Z19
+    uint16_t pm1, pm25, pm10;
+    uint16_t pm1a, pm25a, pm10a;
+    uint16_t cnt03, cnt05, cnt1, cnt25, cnt5, cnt10;
+    uint16_t co2;
+    int16_t temperature;
+} FrameValues;
+
+bool frameDecode(FRAME_TYPE type, const uint8_t *frame, uint8_t length, FrameValues *values);
+
+uint16_t modbusCRC(const uint8_t *data, uint8_t length);
+
+uint8_t sensirionCRC(const uint8_t *data, uint8_t length);
+
+int frameScore(const uint8_t *data, size_t length, FRAME_TYPE *best = nullptr);
+
+#endif
@@ -2,15 +2,53 @@
 
 DHT_nonblocking dht_sensor(DHT_SENSOR_PIN, DHT_SENSOR_TYPE);
 
-#define X(unit, symbol, name) symbol, 
-const char *unit_symbol[] = { SENSOR_UNITS };
+#define X(unit, symbol, name, scale, slot) {unit, symbol, name, scale, unitSlot(slot)},
+const Sensors::UnitDescriptor Sensors::unit_descriptors[UNITS_BUILTIN] = { SENSOR_UNITS };
 #undef X
 
-#define X(unit, symbol, name) name,
-char const *unit_name[] = { SENSOR_UNITS }; 
+// units provided by each built-in driver, the first one is its primary unit
+#define UNITS_LIST(...) {__VA_ARGS__, NUNIT}
+#define UNITS_FIRST(...) UNITS_FIRST_(__VA_ARGS__, )
+#define UNITS_FIRST_(first, ...) first
+#define X(driver, name, device, units, address, alt, khz, period, lead, init, start, read) \
+    static const UNIT driver##_units[] = UNITS_LIST units;
+SENSOR_DRIVERS
 #undef X
 
-uint8_t units_registered [MAX_UNITS_SUPPORTED];
+#define X(driver, name, device, units, address, alt, khz, period, lead, init, start, read)                      \
+    {name, device, UNITS_FIRST units, driver##_units, address, period, lead,                                    \
+     address != 0 ? &driverProbe<address, alt> : nullptr, driverThunk<&Sensors::init>, driverThunk<&Sensors::start>, \
+     driverThunk<&Sensors::read>},
+const DriverOps Sensors::builtin_drivers[DRIVER_COUNT] = { SENSOR_DRIVERS };
+#undef X
+
+// extra UART sensors, sources after the instances (see addUARTSensor)
+const DriverOps Sensors::uart_slot_driver = {"UART slot", nullptr, NUNIT, nullptr, 0, 0, 0, nullptr,
+                                             driverThunk<&Sensors::uartSlotInit>, nullptr,
+                                             driverThunk<&Sensors::uartSlotRead>};
+
+// units of the extra UART sensors, the first one is its primary unit
+static const UNIT uart_pm_units[] = {PM25, PM1, PM10, NUNIT};
+static const UNIT uart_co2_units[] = {CO2, CO2TEMP, NUNIT};
+
+const DriverOps *Sensors::external_drivers[SENSORLIB_EXTERNAL_DRIVERS];
+uint8_t Sensors::external_drivers_count = 0;
+
+uint16_t units_registered [MAX_UNITS_SUPPORTED];
+
+#ifdef ARDUINO_ARCH_ESP32
+RTC_DATA_ATTR SensorsCache rtc_detection_cache;  // it survives to deep sleep
+#endif
+
+// units snapshot lock, the bulk export could be called from other task
+#ifdef ARDUINO_ARCH_ESP32
+static portMUX_TYPE snapshot_mux = portMUX_INITIALIZER_UNLOCKED;
+#define SNAPSHOT_LOCK() portENTER_CRITICAL(&snapshot_mux)
+#define SNAPSHOT_UNLOCK() portEXIT_CRITICAL(&snapshot_mux)
+#else
+#define SNAPSHOT_LOCK() noInterrupts()
+#define SNAPSHOT_UNLOCK() interrupts()
+#endif
 
 /***********************************************************************************
  *  P U B L I C   M E T H O D S
@@ -22,27 +60,31 @@ uint8_t units_registered [MAX_UNITS_SUPPORTED];
  */
 void Sensors::loop() {
     static uint32_t pmLoopTimeStamp = 0;                 // timestamp for sensor loop check data
-    if ((millis() - pmLoopTimeStamp > sample_time * (uint32_t)1000)) {  // sample time for each capture
+    uartSlotsService();
+    uint32_t period = adaptive_sampling ? sample_min : sample_time * (uint32_t)1000;
+    if ((millis() - pmLoopTimeStamp > period)) {  // sample time for each capture
         pmLoopTimeStamp = millis();
         dataReady = false;
         resetUnitsRegister();
-        if(!i2conly ) {
-            dataReady = pmSensorRead();
-            DEBUG("-->[SLIB] UART data ready\t: ",String(dataReady).c_str());
-        }
 
-        dhtRead();
-        am2320Read();
-        bme280Read();
-        bmp280Read();
-        bme680Read();
-        aht10Read();
-        sht31Read();
-        CO2scd30Read();
-        CO2scd4xRead();
-        PMGCJA5Read();
+        // drivers deferred by the I2C bus budget are read first
+        uint32_t deferred = i2c_bus_deferred;
+        i2c_bus_deferred = 0;
+        i2c_bus_used = 0;
+        for (int i = 0; i < SOURCES_MAX; i++) driverStart(i);
+        for (int i = 0; i < SOURCES_MAX; i++) {
+            if (deferred & (1UL << i)) sourceRead(i);
+        }
+        for (int i = 0; i < SOURCES_MAX; i++) {
+            if (!(deferred & (1UL << i))) sourceRead(i);
+        }
+        i2cMuxRelease();
+        i2c_bus_usage = i2c_bus_used;
+        unitsValueRegister();
 
-        if(i2conly && dev_uart_type == SSPS30) sps30Read();
+        thFusion();
+        pmHumidityCorrection();
+        unitsSnapshot();
 
         if(!dataReady)DEBUG("-->[SLIB] Any data from sensors? check your wirings!");
 
@@ -51,12 +93,15 @@ void Sensors::loop() {
         } else if (!dataReady && (_onErrorCb != nullptr))
             _onErrorCb("[W][SLIB] No data from any sensor!");
 
+        if (dataReady) checkChangedUnits();
+
         printValues();
         printUnitsRegistered();
         if (units_registered_count == 0) resetAllVariables();
     }
 
-    dhtRead();  // DHT2x sensors need check fastest
+    uint32_t elapsed = millis() - pmLoopTimeStamp;
+    driversSchedule(elapsed >= period ? 0 : period - elapsed);
 }
 
 /**
@@ -80,11 +125,25 @@ void Sensors::init(int pms_type, int pms_rx, int pms_tx) {
     }
  
     Serial.println("-->[SLIB] temperature offset\t: " + String(toffset));
+    unitPipeline<TEMP>().stage<OffsetStage>().offset = toSValue(toffset);
+    loadCalibrationCurves();
     Serial.println("-->[SLIB] altitude offset   \t: " + String(altoffset));
     Serial.println("-->[SLIB] only i2c sensors  \t: " + String(i2conly));
 
-    if (!i2conly && !sensorSerialInit(pms_type, pms_rx, pms_tx)) {
-        DEBUG("-->[SLIB] not found any PM sensor via UART");
+    SensorsCache cache;
+    bool cached = detection_cache && loadDetectionCache(&cache) && cache.pms_type == pms_type &&
+                  cache.pms_rx == (int8_t)pms_rx && cache.pms_tx == (int8_t)pms_tx;
+    if (cached) DEBUG("-->[SLIB] detection cache found\t: ", uartDeviceName(cache.uart_type));
+
+    uart_detected = false;
+    if (!i2conly && cached && cache.uart_type < 0) {
+        DEBUG("-->[SLIB] detection cache without UART sensor, probing..");
+        uart_detected = sensorSerialProbe(pms_type, pms_rx, pms_tx);
+    } else if (!i2conly) {
+        uart_detected = cached && sensorSerialCachedInit(&cache);
+        if (!uart_detected) cached = false;
+        if (!uart_detected) uart_detected = sensorSerialInit(pms_type, pms_rx, pms_tx);
+        if (!uart_detected) DEBUG("-->[SLIB] not found any PM sensor via UART");
     }
 
 #ifdef M5STICKCPLUS
@@ -92,26 +151,70 @@ void Sensors::init(int pms_type, int pms_rx, int pms_tx) {
 #else
     Wire.begin();
 #endif
+    Wire.setClock(I2C_CLOCK_DEFAULT * 1000UL);  // detection on standard mode
+    for (int i = 0; i < i2c_muxes_count; i++) {  // mux channels closed, only the main bus
+        mux_selected = i;
+        i2cMuxRelease();
+    }
     
+    sourcesInit();
     DEBUG("-->[SLIB] trying to load I2C sensors..");
-    sps30I2CInit();
-    PMGCJA5Init();
-    am2320Init();
-    sht31Init();
-    bme280Init();
-    bmp280Init();
-    bme680Init();
-    aht10Init();
-    dhtInit();
-    CO2scd30Init();
-    CO2scd4xInit();
+    for (int i = 0; i < DRIVER_COUNT + external_drivers_count; i++) {
+        if (cached && i < DRIVER_COUNT && !(cache.drivers & (1UL << i))) continue;
+        driverInit((SENSOR_DRIVER)i);
+    }
+    // cached sensors not found, trying again the full detection
+    if (cached && (drivers_detected & cache.drivers) != cache.drivers) {
+        DEBUG("-->[SLIB] detection cache invalid, loading all I2C sensors..");
+        for (int i = 0; i < DRIVER_COUNT; i++) {
+            if (!(drivers_detected & (1UL << i))) driverInit((SENSOR_DRIVER)i);
+        }
+    }
+
+    if (detection_cache) saveDetectionCache(pms_type, pms_rx, pms_tx, uart_detected);
+    if (uart_detected) uartMainStreamInit();
+    instancesInit();
+    co2TempOffsetApply();
+    i2cClockApply();
+}
+
+/**
+ * Detection cache for a fast warm boot. The sensors detected are saved
+ * on RTC memory (deep sleep) and NVS (power off), and on the next init
+ * they are validated with one cheap probe, skipping the full detection.
+ * Please call it before init()
+ */
+void Sensors::setDetectionCache(bool enable) {
+    detection_cache = enable;
+}
+
+/**
+ * UART baud rate and framing detection for Auto type (9600 8N1 and 8E1,
+ * and 115200 for SPS30). Please call it before init()
+ */
+void Sensors::setUARTAutoBaud(bool enable) {
+    uart_autobaud = enable;
+}
+
+/// clear the detection cache, the next init will do a full detection
+void Sensors::clearDetectionCache() {
+#ifdef ARDUINO_ARCH_ESP32
+    rtc_detection_cache.magic = 0;
+    Preferences preferences;
+    preferences.begin("sensorlib", false);
+    preferences.remove("detection");
+    preferences.end();
+#elif defined(ARDUINO_ARCH_ESP8266)
+    SensorsCache cache = {};
+    ESP.rtcUserMemoryWrite(SENSORLIB_RTC_OFFSET, (uint32_t *)&cache, sizeof(cache));
+#endif
 }
 
 /// set loop time interval for each sensor sample
 void Sensors::setSampleTime(int seconds) {
     sample_time = seconds;
     Serial.println("-->[SLIB] new sample time\t: " + String(seconds));
-    if(getMainDeviceSelected().equals("SCD30")){
+    if (main_driver == DRIVER_SCD30) {
         scd30.setMeasurementInterval(seconds);
         if (devmode) Serial.println("-->[SLIB] SCD30 interval time\t: " + String(seconds));
     }
@@ -119,7 +222,7 @@ void Sensors::setSampleTime(int seconds) {
 
 /// set CO2 recalibration PPM value (400 to 2000)
 void Sensors::setCO2RecalibrationFactor(int ppmValue) {
-    if (getMainDeviceSelected().equals("SCD30")) {
+    if (main_driver == DRIVER_SCD30) {
         Serial.println("-->[SLIB] SCD30 setting calibration to\t: " + String(ppmValue));
         scd30.setForcedRecalibrationFactor(ppmValue);
     }
@@ -135,7 +238,7 @@ void Sensors::setCO2RecalibrationFactor(int ppmValue) {
         Serial.println("-->[SLIB] SenseAir S8 setting calibration to\t: " + String(ppmValue));
         if (s8->manual_calibration()) Serial.println("-->[SLIB] S8 calibration ready.");
     }
-    if (getMainDeviceSelected().equals("SCD4x")) {
+    if (main_driver == DRIVER_SCD4X) {
         Serial.println("-->[SLIB] SCD4x setting calibration to\t: " + String(ppmValue));
         uint16_t frcCorrection;
         uint16_t error = 0;
@@ -150,7 +253,7 @@ void Sensors::setCO2RecalibrationFactor(int ppmValue) {
             return;
         }
         delay(50);
-        scd4x.startPeriodicMeasurement();
+        scd4xMeasurementStart(sources[DRIVER_SCD4X]);
     }
 }
 
@@ -158,20 +261,135 @@ void Sensors::setCO2AltitudeOffset(float altitude){
     this->altoffset = altitude;
     this->hpa = hpaCalculation(altitude);       //hPa hectopascal calculation based on altitude
 
-    if (getMainDeviceSelected().equals("SCD30")) {
+    if (main_driver == DRIVER_SCD30) {
         setSCD30AltitudeOffset(altoffset);
     }
-    if (getMainDeviceSelected().equals("SCD4x")) {
+    if (main_driver == DRIVER_SCD4X) {
         scd4x.stopPeriodicMeasurement();
         delay(510);
         scd4x.setSensorAltitude(altoffset);
         delay(100);
-        scd4x.startPeriodicMeasurement();
+        scd4xMeasurementStart(sources[DRIVER_SCD4X]);
+    }
+}
+
+/**
+ * Live barometric CO2 compensation. The smoothed pressure of BME280, BMP280
+ * or BME680 is used on the CO2 correction of MH-Z19, CM1106 and S8, instead
+ * of the static pressure from the altitude. On SCD30 and SCD4x the ambient
+ * pressure is sent to the sensor (rate limited).
+ */
+void Sensors::setCO2PressureCompensation(bool enable) {
+    co2_live_pressure = enable;
+    Serial.println("-->[SLIB] CO2 live pressure comp\t: " + String(enable));
+}
+
+/// pressure used on the CO2 compensation (hPa)
+float Sensors::getCO2CompensationPressure() {
+    if (co2_live_pressure && pres_smoothed > 0) return fromSValue(pres_smoothed);
+    return hpa;
+}
+
+/**
+ * Piecewise-linear calibration curve of one unit (PM1, PM2.5, PM4, PM10, CO2,
+ * temperature and humidity), applied on the read path (fixed-point math with
+ * SENSORLIB_FIXED_POINT).
+ * @param x sensor values (breakpoints), strictly increasing
+ * @param y reference values for each breakpoint
+ * @param points number of breakpoints (max CALIBRATION_MAX_POINTS)
+ * @return false if the unit or the breakpoints are not valid
+ */
+bool Sensors::setCalibrationCurve(UNIT unit, const float *x, const float *y, uint8_t points) {
+    CalibrationStage *curve = getCalibrationStage(unit);
+    if (curve == nullptr || points > CALIBRATION_MAX_POINTS) return false;
+    for (int i = 1; i < points; i++) {
+        if (x[i] <= x[i - 1]) return false;
+    }
+    curve->points = 0;  // disabled while it is updated
+    for (int i = 0; i < points; i++) {
+        curve->x[i] = toSValue(x[i]);
+        curve->y[i] = toSValue(y[i]);
+    }
+    curve->points = points;
+    DEBUG("-->[SLIB] calibration curve points\t: ", String(points).c_str());
+    return true;
+}
+
+void Sensors::clearCalibrationCurve(UNIT unit) {
+    CalibrationStage *curve = getCalibrationStage(unit);
+    if (curve != nullptr) curve->points = 0;
+}
+
+/**
+ * Streaming outlier filter (Hampel) for PM1, PM2.5, PM4, PM10 and CO2. Single
+ * sample spikes are replaced by the median of the last HAMPEL_WINDOW samples
+ * on the read path, before callbacks, statistics and the units export.
+ * @param sigmas threshold in sigmas (1.4826 * median absolute deviation)
+ * @param min_deviation min deviation (unit value) to flag an outlier
+ * @return false if the unit is not supported
+ */
+bool Sensors::setOutlierFilter(UNIT unit, bool enable, float sigmas, float min_deviation) {
+    HampelStage *filter = getHampelStage(unit);
+    if (filter == nullptr) return false;
+    filter->k = enable ? (uint16_t)constrain(round(sigmas * 100), 1, 65535) : 0;
+    filter->min_deviation = toSValue(min_deviation);
+    filter->count = 0;
+    filter->head = 0;
+    filter->outlier = false;
+    Serial.println("-->[SLIB] outlier filter " + String(unitName(unit)) + "\t: " + String(enable));
+    return true;
+}
+
+/// true if the last value of the unit was replaced by the outlier filter
+bool Sensors::isUnitOutlier(UNIT unit) {
+    HampelStage *filter = getHampelStage(unit);
+    return filter != nullptr && filter->outlier;
+}
+
+/// outliers replaced on the unit since the filter was enabled
+uint32_t Sensors::getUnitOutliers(UNIT unit) {
+    HampelStage *filter = getHampelStage(unit);
+    return filter == nullptr ? 0 : filter->outliers;
+}
+
+/// save all calibration curves on NVS (ESP32), they are loaded on init()
+bool Sensors::saveCalibrationCurves() {
+#ifdef ARDUINO_ARCH_ESP32
+    Preferences preferences;
+    if (!preferences.begin("sensorlib_cal", false)) return false;
+    for (size_t i = 1; i < UNITS_BUILTIN; i++) {
+        CalibrationStage *curve = getCalibrationStage((UNIT)i);
+        if (curve == nullptr) continue;
+        if (curve->points == 0)
+            preferences.remove(unit_descriptors[i].name);
+        else
+            preferences.putBytes(unit_descriptors[i].name, curve, sizeof(CalibrationStage));
+    }
+    preferences.end();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Sensors::loadCalibrationCurves() {
+#ifdef ARDUINO_ARCH_ESP32
+    Preferences preferences;
+    if (!preferences.begin("sensorlib_cal", true)) return;
+    for (size_t i = 1; i < UNITS_BUILTIN; i++) {
+        const char *key = unit_descriptors[i].name;
+        CalibrationStage *curve = getCalibrationStage((UNIT)i);
+        if (curve == nullptr || preferences.getBytesLength(key) != sizeof(CalibrationStage)) continue;
+        preferences.getBytes(key, curve, sizeof(CalibrationStage));
+        if (curve->points > CALIBRATION_MAX_POINTS) curve->points = 0;
+        DEBUG("-->[SLIB] calibration curve loaded\t: ", key);
     }
+    preferences.end();
+#endif
 }
 
 void Sensors::restart() {
-    _serial->flush();
+    if (_serial != nullptr) _serial->flush();
     init();
     delay(100);
 }
@@ -184,6 +402,272 @@ void Sensors::setOnErrorCallBack(errorCbFn cb) {
     _onErrorCb = cb;
 }
 
+/**
+ * Callback for change-driven reporting. It is only fired when at least one
+ * registered unit moved beyond its deadband, or when the max silence time
+ * (heartbeat) expires. The callback receives the mask of changed units
+ * (bit N is UNIT N), on heartbeat it could be zero.
+ */
+void Sensors::setOnChangedCallBack(unitsChangedCbFn cb) {
+    _onChangedCb = cb;
+}
+
+/**
+ * Callback on each valid UART frame (header and checksum), main and extra
+ * UART sensors. With UART events it runs on the UART task: keep it short.
+ */
+void Sensors::setOnFrameCallBack(frameCbFn cb) {
+    _onFrameCb = cb;
+}
+
+/**
+ * Deadband for change-driven reporting.
+ * @param unit sensor unit (see UNIT enum)
+ * @param absolute minimal absolute change (unit value) to report it
+ * @param relative minimal relative change (0.05 is 5%) to report it
+ * With both thresholds on zero (default), any change is reported.
+ */
+void Sensors::setUnitDeadband(UNIT unit, float absolute, float relative) {
+    if (unit >= MAX_UNITS_SUPPORTED) return;
+    unit_deadband_abs[unit] = toSValue(absolute);
+    unit_deadband_rel[unit] = (uint16_t)constrain(round(relative * 1000), 0, 65535);
+}
+
+/// max time without changed callback (heartbeat). 0 disable it.
+void Sensors::setMaxSilenceTime(int seconds) {
+    max_silence = seconds * (uint32_t)1000;
+}
+
+/// units changed on the last sample round
+const UnitsMask &Sensors::getChangedUnits() {
+    return changed_units;
+}
+
+/**
+ * Adaptive sampling. Each driver starts on the fastest period and it is
+ * doubled while its primary unit is stable (EWMA variance), up to the
+ * slowest period. A fast change snaps it back to the fastest period.
+ * @param enable enable or disable it (disabled, sample time is used)
+ * @param min_seconds fastest sample period
+ * @param max_seconds slowest sample period
+ */
+void Sensors::setAdaptiveSampling(bool enable, int min_seconds, int max_seconds) {
+    adaptive_sampling = enable;
+    sample_min = min_seconds * (uint32_t)1000;
+    sample_max = max(min_seconds, max_seconds) * (uint32_t)1000;
+    for (int i = 0; i < SOURCES_MAX; i++) driver_interval[i] = 0;
+    Serial.println("-->[SLIB] adaptive sampling\t: " + String(enable));
+}
+
+/// current sample period of one driver (seconds)
+int Sensors::getDriverSampleTime(SENSOR_DRIVER driver) {
+    if (!adaptive_sampling || driver >= DRIVERS_MAX) return sample_time;
+    return driver_interval[driver] / 1000;
+}
+
+String Sensors::getDriverName(SENSOR_DRIVER driver) {
+    return String(driverName(driver));
+}
+
+/// units provided by a driver, empty if they are not known (UART, external drivers without units)
+UnitsMask Sensors::getDriverUnits(SENSOR_DRIVER driver) {
+    UnitsMask units;
+    const DriverOps *ops = driverOps(driver);
+    if (ops == nullptr || ops->units == nullptr) return units;
+    for (const UNIT *unit = ops->units; *unit != NUNIT; unit++) units.set(*unit);
+    return units;
+}
+
+/**
+ * External sensor driver (see SensorDriver and SENSORLIB_DRIVER), it is
+ * initialized and read like the built-in drivers. Up to
+ * SENSORLIB_EXTERNAL_DRIVERS, please call it before init()
+ */
+bool Sensors::registerDriver(const DriverOps *ops) {
+    if (ops == nullptr || ops->init == nullptr || ops->collect == nullptr) return false;
+    if (external_drivers_count >= SENSORLIB_EXTERNAL_DRIVERS) return false;
+    external_drivers[external_drivers_count++] = ops;
+    return true;
+}
+
+/**
+ * Exponential backoff for failing drivers (enabled by default). After
+ * HEALTH_FAIL_THRESHOLD reads without data, the driver is retried each
+ * 2^level sample periods (up to HEALTH_BACKOFF_MAX) and it is initialized
+ * again before each retry, then a dead sensor doesn't use bus time.
+ */
+void Sensors::setDriverBackoff(bool enable) {
+    driver_backoff = enable;
+    if (enable) return;
+    for (int i = 0; i < SOURCES_MAX; i++) driver_health[i].backoff = 0;
+}
+
+/// consecutive failures, last success time and backoff level of one driver
+DriverHealth Sensors::getDriverHealth(SENSOR_DRIVER driver) {
+    if (driver >= DRIVERS_MAX) return DriverHealth();
+    return driver_health[driver];
+}
+
+bool Sensors::isDriverHealthy(SENSOR_DRIVER driver) {
+    return isDriverDetected(driver) && driver_health[driver].failures < HEALTH_FAIL_THRESHOLD;
+}
+
+/**
+ * Max I2C clock of one driver (kHz), it overrides the default of the
+ * drivers table (i.e. long wires or a sensor with issues on fast mode).
+ * After init the bus runs with the fastest clock that all I2C sensors
+ * detected support.
+ */
+void Sensors::setI2CClock(SENSOR_DRIVER driver, uint16_t khz) {
+    if (!isI2CDriver(driver)) return;
+    i2c_clock[driver] = khz;
+    if (drivers_detected) i2cClockApply();
+}
+
+/// current I2C bus clock (Hz)
+uint32_t Sensors::getI2CClock() {
+    return i2c_clock_applied * 1000UL;
+}
+
+/**
+ * Max I2C bus time for each sample round (ms), 0 is disabled (default).
+ * The bus time of each driver read is measured (EWMA), and the drivers
+ * that don't fit on the budget are deferred to the next round, keeping
+ * its last values. At least one driver is read on each round.
+ */
+void Sensors::setI2CBusBudget(int milliseconds) {
+    i2c_bus_budget = max(milliseconds, 0) * (uint32_t)1000;
+    Serial.println("-->[SLIB] I2C bus budget	: " + String(milliseconds) + "ms");
+}
+
+/// average read time of one I2C driver (us), transactions and conversion waits
+uint32_t Sensors::getI2CBusTime(SENSOR_DRIVER driver) {
+    if (driver >= DRIVERS_MAX) return 0;
+    return driver_bus_time[driver];
+}
+
+/// I2C bus time of the last sample round (us)
+uint32_t Sensors::getI2CBusUsage() {
+    return i2c_bus_usage;
+}
+
+/**
+ * Extra I2C bus for sensor instances, i.e. the second ESP32 I2C port
+ * (Wire1), already started with its pins. Please call it before init()
+ */
+bool Sensors::addI2CBus(TwoWire *bus) {
+    if (bus == nullptr || bus == &Wire || i2c_buses_count >= I2C_BUS_MAX) return false;
+    i2c_buses[i2c_buses_count++] = bus;
+    return true;
+}
+
+/**
+ * TCA9548A (8 channels) or TCA9546A (4 channels) multiplexer, for many
+ * sensors with the same address. The sensors found on each channel are
+ * sensor instances. Please call it before init()
+ */
+bool Sensors::addI2CMux(TwoWire *bus, uint8_t address) {
+    if (bus == nullptr || i2c_muxes_count >= I2C_MUX_MAX) return false;
+    i2c_muxes[i2c_muxes_count].bus = bus;
+    i2c_muxes[i2c_muxes_count].address = address;
+    i2c_muxes_count++;
+    return true;
+}
+
+/// sensors found on the extra I2C buses and mux channels
+uint8_t Sensors::getInstancesCount() {
+    return instances_count;
+}
+
+SENSOR_DRIVER Sensors::getInstanceDriver(uint8_t instance) {
+    if (instance >= instances_count) return (SENSOR_DRIVER)DRIVERS_MAX;
+    return sources[DRIVERS_MAX + instance].driver;
+}
+
+/// mux channel of one instance, -1 without mux
+int Sensors::getInstanceChannel(uint8_t instance) {
+    if (instance >= instances_count) return -1;
+    return sources[DRIVERS_MAX + instance].channel;
+}
+
+/**
+ * Unit of the registry of one instance for a unit of its driver, i.e.
+ * getInstanceUnit(0, TEMP) is "Temp.1". Its values are read like any
+ * other unit (getNextUnit, getUnitsValues, on changed callback).
+ * @return NUNIT if the instance hasn't the unit (or the registry is full)
+ */
+UNIT Sensors::getInstanceUnit(uint8_t instance, UNIT unit) {
+    if (instance >= instances_count) return NUNIT;
+    return sourceUnit(DRIVERS_MAX + instance, unit);
+}
+
+/// millis() of the last read with data of one instance
+uint32_t Sensors::getInstanceTimestamp(uint8_t instance) {
+    if (instance >= instances_count) return 0;
+    return driver_health[DRIVERS_MAX + instance].last_success;
+}
+
+/**
+ * Temperature and humidity fusion when there are multiple sources.
+ * FUSION_LAST: the last driver read wins (legacy)
+ * FUSION_MEAN: weighted mean of all sources (see setSourceWeight)
+ * FUSION_MEDIAN: median of all sources with weight
+ */
+void Sensors::setTHFusionMode(FUSION_MODE mode) {
+    th_fusion = mode;
+}
+
+/**
+ * Measurement profile of the drivers, for battery and mains powered nodes:
+ * PROFILE_DEFAULT: settings of previous versions
+ * PROFILE_LOW_LATENCY: minimal oversampling and filters, fast conversions
+ * PROFILE_LOW_POWER: forced mode (BME280, BMP280), BME680 without gas heater,
+ * SCD4x single shot (SCD41) or low power periodic mode (SCD40), SHT31 low
+ * repeatability and sample time of PROFILE_LOW_POWER_SAMPLE_TIME at least
+ * PROFILE_HIGH_PRECISION: max oversampling and filters
+ * It could be called before or after init().
+ */
+void Sensors::setMeasurementProfile(MEASURE_PROFILE profile) {
+    measure_profile = profile;
+    if (profile == PROFILE_LOW_POWER && sample_time < PROFILE_LOW_POWER_SAMPLE_TIME)
+        setSampleTime(PROFILE_LOW_POWER_SAMPLE_TIME);
+    for (int i = 0; i < DRIVERS_MAX + instances_count; i++) {
+        if (i >= DRIVERS_MAX || (drivers_detected & (1UL << i))) profileApply(sources[i]);
+    }
+    Serial.println("-->[SLIB] measurement profile\t: " + String(profile));
+}
+
+Sensors::MEASURE_PROFILE Sensors::getMeasurementProfile() {
+    return measure_profile;
+}
+
+/// weight of one source on the fusion (0.0 to 255.0). With 0.0 the source is ignored.
+void Sensors::setSourceWeight(SENSOR_DRIVER driver, float weight) {
+    if (driver >= DRIVERS_MAX) return;
+    source_weight[driver] = (uint16_t)constrain(round(weight * SOURCE_WEIGHT_ONE), 0, 65535);
+    source_weight_set |= (1UL << driver);
+}
+
+/// the driver has a fresh temperature sample (see SOURCE_FRESH_PERIODS)
+bool Sensors::isTemperatureSource(SENSOR_DRIVER driver) {
+    return driver < DRIVERS_MAX && (source_temp_mask & (1UL << driver)) && isSourceFresh(driver, source_temp_time[driver]);
+}
+
+/// the driver has a fresh humidity sample (see SOURCE_FRESH_PERIODS)
+bool Sensors::isHumiditySource(SENSOR_DRIVER driver) {
+    return driver < DRIVERS_MAX && (source_humi_mask & (1UL << driver)) && isSourceFresh(driver, source_humi_time[driver]);
+}
+
+/// temperature of one source (driver), without fusion
+float Sensors::getSourceTemperature(SENSOR_DRIVER driver) {
+    return isTemperatureSource(driver) ? fromSValue(source_temp[driver]) : 0.0;
+}
+
+/// humidity of one source (driver), without fusion
+float Sensors::getSourceHumidity(SENSOR_DRIVER driver) {
+    return isHumiditySource(driver) ? fromSValue(source_humi[driver]) : 0.0;
+}
+
 void Sensors::setDebugMode(bool enable) {
     devmode = enable;
 }
@@ -232,6 +716,112 @@ String Sensors::getStringPM10() {
     return String(output);
 }
 
+uint16_t Sensors::getPM1Corrected() {
+    return pm1c;
+}
+
+uint16_t Sensors::getPM25Corrected() {
+    return pm25c;
+}
+
+uint16_t Sensors::getPM4Corrected() {
+    return pm4c;
+}
+
+uint16_t Sensors::getPM10Corrected() {
+    return pm10c;
+}
+
+/// PM1 atmospheric environment (ug/m3), only Plantower
+uint16_t Sensors::getPM1Atm() {
+    return pm1a;
+}
+
+uint16_t Sensors::getPM25Atm() {
+    return pm25a;
+}
+
+uint16_t Sensors::getPM10Atm() {
+    return pm10a;
+}
+
+/// particles > 0.3um in 0.1L of air, only Plantower
+uint16_t Sensors::getCount03() {
+    return cnt03;
+}
+
+uint16_t Sensors::getCount05() {
+    return cnt05;
+}
+
+uint16_t Sensors::getCount1() {
+    return cnt1;
+}
+
+uint16_t Sensors::getCount25() {
+    return cnt25;
+}
+
+uint16_t Sensors::getCount5() {
+    return cnt5;
+}
+
+uint16_t Sensors::getCount10() {
+    return cnt10;
+}
+
+/// number concentration of PM0.5 (#/cm3), only SPS30
+float Sensors::getNumPM05() {
+    return fromSValue(npm05);
+}
+
+float Sensors::getNumPM1() {
+    return fromSValue(npm1);
+}
+
+float Sensors::getNumPM25() {
+    return fromSValue(npm25);
+}
+
+float Sensors::getNumPM4() {
+    return fromSValue(npm4);
+}
+
+float Sensors::getNumPM10() {
+    return fromSValue(npm10);
+}
+
+/// typical particle size (um), only SPS30
+float Sensors::getPartSize() {
+    return fromSValue(psize);
+}
+
+/**
+ * SPS30 mass only read. Number concentrations and particle size are not
+ * registered. The values are read by the SPS30 library on its bus, it
+ * stops the I2C transfer after the mass values on small I2C buffers.
+ */
+void Sensors::setSPS30MassOnly(bool enable) {
+    sps30_mass_only = enable;
+}
+
+/**
+ * PM humidity correction (hygroscopic growth), kappa-Kohler:
+ * PMdry = PMwet / (1 + (kappa / 1.65) / (100 / RH - 1))
+ * The factor is precomputed on a table for each %RH, then the per-sample
+ * cost is an integer multiplication. Raw values are still published, and
+ * the corrected values are registered as PM1c, PM2.5c, PM4c and PM10c.
+ * @param kappa hygroscopicity (0.4 default, urban aerosol)
+ */
+void Sensors::setPMHumidityCorrection(bool enable, float kappa) {
+    pm_humi_correction = enable;
+    for (int rh = 0; rh <= PM_LUT_RH_MAX; rh++) {
+        float growth = rh == 0 ? 1.0 : 1.0 + (kappa / 1.65) / (100.0 / rh - 1.0);
+        pm_humi_lut[rh] = (uint16_t)round(32768.0 / growth);
+    }
+    Serial.println("-->[SLIB] PM humidity correction\t: " + String(enable));
+}
+
 uint16_t Sensors::getCO2() {
     return CO2Val;
 }
@@ -243,37 +833,96 @@ String Sensors::getStringCO2() {
 }
 
 float Sensors::getCO2humi() {
-    return CO2humi;
+    return fromSValue(CO2humi);
 }
 
 float Sensors::getCO2temp() {
-    return CO2temp;
+    return fromSValue(CO2temp);
 }
 
 float Sensors::getHumidity() {
-    return humi;
+    return fromSValue(humi);
 }
 
 float Sensors::getTemperature() {
-    return temp;
+    return fromSValue(temp);
 }
 
 void Sensors::setTempOffset(float offset){
     toffset = offset;
+    unitPipeline<TEMP>().stage<OffsetStage>().offset = toSValue(offset);
+    co2TempOffsetApply();
     setSCD30TempOffset(toffset);
     setSCD4xTempOffset(toffset);
 }
 
+/// temperature offset of the CO2 sensors without it on the chip (MH-Z19), SCD30 and SCD4x apply it internally
+void Sensors::co2TempOffsetApply() {
+    bool onchip = isDriverDetected(DRIVER_SCD30) || isDriverDetected(DRIVER_SCD4X);
+    unitPipeline<CO2TEMP>().stage<OffsetStage>().offset = onchip ? 0 : toSValue(toffset);
+}
+
 float Sensors::getGas() {
-    return gas;
+    return fromSValue(gas);
 }
 
 float Sensors::getAltitude() {
-    return alt;
+    return fromSValue(alt);
 }
 
 float Sensors::getPressure() {
-    return pres;
+    return fromSValue(pres);
+}
+
+/**
+ * Extra UART sensor on its own port, already started with its pins and
+ * baud rate (9600 for all types, 8E1 for Panasonic). Supported: Auto
+ * (Plantower and Honeywell), Panasonic, SDS011, Mhz19, CM1106 and
+ * SENSEAIRS8. CO2 sensors are requested on each sample round and its
+ * answer is published on the next one. It is a source with its own units
+ * on the registry (see getUARTSensorUnit). Please call it before init()
+ */
+bool Sensors::addUARTSensor(int type, Stream *serial) {
+    if (serial == nullptr || uart_slots_count >= UART_SLOTS_MAX || uartFrameType(type) == FRAME_NONE) return false;
+    UARTSlot *slot = &uart_slots[uart_slots_count];
+    uartSlotBegin(slot, serial, type, uartFrameType(type));
+    SensorInstance &instance = sources[UART_SOURCES_FIRST + uart_slots_count];
+    instance = SensorInstance();
+    instance.driver = DRIVER_UART;
+    instance.bus = nullptr;
+    instance.mux = -1;
+    instance.channel = -1;
+    instance.device.uart = slot;
+    instance.units_first = NUNIT;
+    sourceUnitsRegister(UART_SOURCES_FIRST + uart_slots_count++);
+    return true;
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+/// extra UART sensor on one ESP32 UART (Serial1 or Serial2), it is started here
+bool Sensors::addUARTSensor(int type, HardwareSerial *serial, int rx, int tx) {
+    if (serial == nullptr || uartFrameType(type) == FRAME_NONE) return false;
+    serial->begin(9600, type == Panasonic ? SERIAL_8E1 : SERIAL_8N1, rx, tx, false);
+    if (!addUARTSensor(type, (Stream *)serial)) return false;
+#ifdef UART_RX_EVENTS
+    uartEventsAttach(serial, &uart_slots[uart_slots_count - 1]);
+#endif
+    return true;
+}
+#endif
+
+uint8_t Sensors::getUARTSensorsCount() {
+    return uart_slots_count;
+}
+
+/**
+ * Unit of the registry of one extra UART sensor, i.e. getUARTSensorUnit(0,
+ * PM25) is "PM2.5.U1". The main UART sensor keeps the built-in units.
+ * @return NUNIT if the sensor hasn't the unit (or the registry is full)
+ */
+UNIT Sensors::getUARTSensorUnit(uint8_t slot, UNIT unit) {
+    if (slot >= uart_slots_count) return NUNIT;
+    return sourceUnit(UART_SOURCES_FIRST + slot, unit);
 }
 
 bool Sensors::isUARTSensorConfigured() {
@@ -315,26 +964,7 @@ int16_t Sensors::getLibraryRevision() {
  *  @return true if header and sensor data is right
  */
 bool Sensors::pmGenericRead() {
-    int lenght_buffer = 32;
-    String txtMsg = hwSerialRead(lenght_buffer);
-    if (txtMsg[0] == 66) {
-        if (txtMsg[1] == 77) {
-            DEBUG("-->[SLIB] UART PMGENERIC read > done!");
-            pm25 = txtMsg[6] * 256 + (char)(txtMsg[7]);
-            pm10 = txtMsg[8] * 256 + (char)(txtMsg[9]);
-
-            unitRegister(UNIT::PM25);
-            unitRegister(UNIT::PM10);
-
-            if (pm25 > 1000 && pm10 > 1000) {
-                onSensorError("[E][SLIB] UART PMGENERIC out of range pm25 > 1000");
-            } else
-                return true;
-        } else {
-            onSensorError("[E][SLIB] UART PMGENERIC invalid sensor header!");
-        }
-    }
-    return false;
+    return uartFramePoll(FRAME_PMS, 32, "PMGENERIC");
 }
 
 /**
@@ -342,26 +972,7 @@ bool Sensors::pmGenericRead() {
  *  @return true if header and sensor data is right
  */
 bool Sensors::pmPanasonicRead() {
-    int lenght_buffer = 32;
-    String txtMsg = hwSerialRead(lenght_buffer);
-    if (txtMsg[0] == 02) {
-        DEBUG("-->[SLIB] PANASONIC read > done!");
-        pm1 = txtMsg[2] * 256 + (char)(txtMsg[1]);
-        pm25 = txtMsg[6] * 256 + (char)(txtMsg[5]);
-        pm10 = txtMsg[10] * 256 + (char)(txtMsg[9]);
-
-        unitRegister(UNIT::PM1);
-        unitRegister(UNIT::PM25);
-        unitRegister(UNIT::PM10);
-
-        if (pm25 > 2000 && pm10 > 2000) {
-            onSensorError("[E][SLIB] PANASONIC out of range pm25 > 2000");
-        } else
-            return true;
-    } else {
-        onSensorError("[E][SLIB] PANASONIC invalid sensor header!");
-    }
-    return false;
+    return uartFramePoll(FRAME_PANASONIC, 32, "PANASONIC");
 }
 
 /**
@@ -369,26 +980,39 @@ bool Sensors::pmPanasonicRead() {
  *  @return true if header and sensor data is right
  */
 bool Sensors::pmSDS011Read() {
-    int lenght_buffer = 10;
-    String txtMsg = hwSerialRead(lenght_buffer);
-    if (txtMsg[0] == 170) {
-        if (txtMsg[1] == 192) {
-            DEBUG("-->[SLIB] SDS011 read > done!");
-            pm25 = (txtMsg[3] * 256 + (char)(txtMsg[2])) / 10;
-            pm10 = (txtMsg[5] * 256 + (char)(txtMsg[4])) / 10;
-
-            unitRegister(UNIT::PM25);
-            unitRegister(UNIT::PM10);
-
-            if (pm25 > 1000 && pm10 > 1000) {
-                onSensorError("[E][SLIB] SDS011 out of range pm25 > 1000");
-            } else
-                return true;
-        } else {
-            onSensorError("[E][SLIB] SDS011 invalid sensor header!");
-        }
+    return uartFramePoll(FRAME_SDS011, 10, "SDS011");
+}
+
+/**
+ * Polling read of the main UART sensor. The frame is validated (header and
+ * checksum) and decoded in one pass, with the decoder of the stream receive.
+ */
+bool Sensors::uartFramePoll(FRAME_TYPE type, unsigned int length, const char *name) {
+    String txtMsg = hwSerialRead(length);
+    FrameMatcher matcher(type);
+    bool found = false;
+    for (unsigned int i = 0; i < txtMsg.length() && !found; i++) found = matcher.push(txtMsg[i]);
+    if (!found) {
+        if (matcher.errors() > 0) onSensorError(("[E][SLIB] " + String(name) + " invalid frame checksum!").c_str());
+        else if (txtMsg.length() > 0) onSensorError(("[E][SLIB] " + String(name) + " invalid sensor header!").c_str());
+        return false;
     }
-    return false;
+    DEBUG("-->[SLIB] UART read > done\t: ", name);
+    return uartFrameDecode(type, matcher.frame(), matcher.length());
+}
+
+/**
+ * @brief Nova SDS011 work mode (fan and laser on) or sleep mode.
+ * Used for power saving when the sample time is long.
+ */
+void Sensors::sds011SetWorkMode(bool work) {
+    uint8_t cmd[19] = {0xAA, 0xB4, 0x06, 0x01, (uint8_t)work, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF, 0, 0xAB};
+    uint8_t checksum = 0;
+    for (int i = 2; i < 17; i++) checksum += cmd[i];
+    cmd[17] = checksum;
+    _serial->write(cmd, sizeof(cmd));
+    sds011_sleeping = !work;
+    DEBUG("-->[SLIB] SDS011 work mode\t: ", String(work).c_str());
 }
 
 /**
@@ -412,18 +1036,121 @@ String Sensors::hwSerialRead(unsigned int lenght_buffer) {
     return txtMsg;
 }
 
-/**
- *  @brief Sensirion SPS30 particulate meter sensor read.
- *  @return true if reads succes
- */
-bool Sensors::sps30Read() {
-    uint8_t ret, error_cnt = 0;
-
-    delay(35);  //Delay for sincronization
-    
-    if(i2conly && sample_time > 30) {
-        if (!sps30.start()) return false;  // power saving validation
-        delay(15000);
+FRAME_TYPE Sensors::uartFrameType(int type) {
+    switch (type) {
+        case Auto:
+            return FRAME_PMS;
+        case Panasonic:
+            return FRAME_PANASONIC;
+        case SDS011:
+            return FRAME_SDS011;
+        case Mhz19:
+            return FRAME_MHZ19;
+        case CM1106:
+            return FRAME_CM1106;
+        case SENSEAIRS8:
+            return FRAME_S8;
+        default:
+            return FRAME_NONE;
+    }
+}
+
+/// pushes the bytes available of the UART sensors without events, it never waits
+void Sensors::uartSlotsService() {
+    if (uart_main_stream && !uart_main.events) uartReceive(&uart_main);
+    for (int i = 0; i < uart_slots_count; i++) {
+        if (!uart_slots[i].events) uartReceive(&uart_slots[i]);
+    }
+}
+
+/// frame receive of one UART sensor with the frame callback (see uartSlotReceive)
+void Sensors::uartReceive(UARTSlot *slot) {
+    uartSlotReceive(slot, _onFrameCb);
+}
+
+/// decode of the last frame received, only once
+bool Sensors::uartSlotPublish(UARTSlot *slot) {
+    uint8_t frame[FRAME_MAX_LENGTH];
+    uint8_t length = uartSlotTake(slot, frame);
+    return length > 0 && uartFrameDecode(slot->matcher.type(), frame, length);
+}
+
+/**
+ * Stream receive of the main UART sensor after its detection (Plantower,
+ * Honeywell, Panasonic and SDS011), instead of the polling on each read.
+ */
+void Sensors::uartMainStreamInit() {
+    if (uartFrameType(dev_uart_type) == FRAME_NONE || dev_uart_type == Mhz19 || dev_uart_type == CM1106 ||
+        dev_uart_type == SENSEAIRS8)
+        return;  // CO2 sensors are read by its libraries (request and answer)
+    uartSlotBegin(&uart_main, _serial, dev_uart_type, uartFrameType(dev_uart_type));
+    uart_main_stream = true;
+#ifdef UART_RX_EVENTS
+    if (uart_hw_serial != nullptr) uartEventsAttach(uart_hw_serial, &uart_main);
+#endif
+    DEBUG("-->[SLIB] UART stream receive\t: ", uart_main.events ? "events" : "loop");
+}
+
+/// extra UART sensor init (retries of its health backoff), its decoder is restarted
+bool Sensors::uartSlotInit(SensorInstance &instance) {
+    instance.device.uart->matcher.reset();
+    return true;
+}
+
+/// extra UART sensor read: its last frame on its own units, then the next CO2 request
+bool Sensors::uartSlotRead(SensorInstance &instance) {
+    UARTSlot *slot = instance.device.uart;
+    bool ready = uartSlotPublish(slot);
+    if (ready) dataReady = true;
+    if (slot->type == Mhz19) slot->serial->write(mhz19_read_cmd, sizeof(mhz19_read_cmd));
+    if (slot->type == CM1106) slot->serial->write(cm1106_read_cmd, sizeof(cm1106_read_cmd));
+    if (slot->type == SENSEAIRS8) slot->serial->write(s8_read_cmd, sizeof(s8_read_cmd));
+    return ready;
+}
+
+/**
+ * Decode of one validated UART frame to the units of the current source,
+ * the main UART sensor or an extra one (see unitPublish).
+ */
+bool Sensors::uartFrameDecode(FRAME_TYPE type, const uint8_t *frame, uint8_t length) {
+    FrameValues values;
+    if (!frameDecode(type, frame, length, &values)) {
+        if (values.has_pm) onSensorError("[E][SLIB] UART PM out of range pm25");
+        return false;
+    }
+    if (values.has_pm) {
+        unitPublish<PM25>(values.pm25);
+        unitPublish<PM10>(values.pm10);
+    }
+    if (values.has_pm1) unitPublish<PM1>(values.pm1);
+    if (values.has_extended) {
+        unitPublish<PM1A>(values.pm1a);
+        unitPublish<PM25A>(values.pm25a);
+        unitPublish<PM10A>(values.pm10a);
+        unitPublish<CNT03>(values.cnt03);
+        unitPublish<CNT05>(values.cnt05);
+        unitPublish<CNT1>(values.cnt1);
+        unitPublish<CNT25>(values.cnt25);
+        unitPublish<CNT5>(values.cnt5);
+        unitPublish<CNT10>(values.cnt10);
+    }
+    if (values.has_co2) CO2Process(values.co2, true);
+    if (values.has_temperature) unitPublish<CO2TEMP>(values.temperature);
+    return true;
+}
+
+/**
+ *  @brief Sensirion SPS30 particulate meter sensor read.
+ *  @return true if reads succes
+ */
+bool Sensors::sps30Read() {
+    uint8_t ret, error_cnt = 0;
+
+    delay(35);  //Delay for sincronization
+    
+    if (isDriverDetected(DRIVER_SPS30) && getDriverSampleTime((SENSOR_DRIVER)current_source) > 30) {
+        if (!sps30.start()) return false;  // power saving validation
+        delay(15000);
     }
     
     do {
@@ -442,61 +1169,62 @@ bool Sensors::sps30Read() {
 
     DEBUG("-->[SLIB] SPS30 read > done!");
 
-    pm1 = round(val.MassPM1);
-    pm25 = round(val.MassPM2);
-    pm4 = round(val.MassPM4);
-    pm10 = round(val.MassPM10);
-
-    unitRegister(UNIT::PM1);
-    unitRegister(UNIT::PM25);
-    unitRegister(UNIT::PM4);
-    unitRegister(UNIT::PM10);
-
-    if(i2conly && sample_time > 30) sps30.stop();  // power saving validation
+    if (isDriverDetected(DRIVER_SPS30) && getDriverSampleTime((SENSOR_DRIVER)current_source) > 30) sps30.stop();  // power saving validation
 
-    if (pm25 > 1000 && pm10 > 1000) {
+    if (val.MassPM2 > 1000 && val.MassPM10 > 1000) {
         onSensorError("[E][SLIB] SPS30 Sensirion out of range pm25 > 1000");
         return false;
     }
 
+    unitPublish<PM1>(val.MassPM1);
+    unitPublish<PM25>(val.MassPM2);
+    unitPublish<PM4>(val.MassPM4);
+    unitPublish<PM10>(val.MassPM10);
+
+    if (!sps30_mass_only && sps30.I2C_expect() != 4) {  // small I2C buffers only have PM values
+        unitPublish<NPM05>(val.NumPM0);
+        unitPublish<NPM1>(val.NumPM1);
+        unitPublish<NPM25>(val.NumPM2);
+        unitPublish<NPM4>(val.NumPM4);
+        unitPublish<NPM10>(val.NumPM10);
+        unitPublish<PSIZE>(val.PartSize);
+    }
+
     dataReady = true;
 
     return true;
 }
 
 bool Sensors::CO2Mhz19Read() {
-    CO2Val = mhz19.getCO2();              // Request CO2 (as ppm)
-    CO2temp = mhz19.getTemperature()-toffset;  // Request Temperature (as Celsius)
-    if (CO2Val > 0) {
-        if(altoffset != 0) CO2correctionAlt();
+    uint16_t co2 = mhz19.getCO2();              // Request CO2 (as ppm)
+    float temp1 = mhz19.getTemperature();       // Request Temperature (as Celsius)
+    if (co2 > 0) {
+        CO2Process(co2, true);
+        unitPublish<CO2TEMP>(temp1);
         dataReady = true;
         DEBUG("-->[SLIB] MHZ14-9 read > done!");
-        unitRegister(UNIT::CO2);
-        unitRegister(UNIT::CO2TEMP);
         return true;
     }
     return false;
 }
 
 bool Sensors::CO2CM1106Read() {
-    CO2Val = cm1106->get_co2();;
-    if (CO2Val > 0) {
+    uint16_t co2 = cm1106->get_co2();
+    if (co2 > 0) {
         dataReady = true;
-        if(altoffset != 0) CO2correctionAlt();
+        CO2Process(co2, true);
         DEBUG("-->[SLIB] CM1106 read > done!");
-        unitRegister(UNIT::CO2);
         return true;
     }
     return false;
 }
 
 bool Sensors::senseAirS8Read() {
-    CO2Val = s8->get_co2();      // Request CO2 (as ppm)
-    if (CO2Val > 0) {
-        if(altoffset != 0) CO2correctionAlt();
+    uint16_t co2 = s8->get_co2();      // Request CO2 (as ppm)
+    if (co2 > 0) {
+        CO2Process(co2, true);
         dataReady = true;
         DEBUG("-->[SLIB] SENSEAIRS8 read > done!");
-        unitRegister(UNIT::CO2);
         return true;
     }
     return false;
@@ -507,6 +1235,11 @@ bool Sensors::senseAirS8Read() {
  * @return true if data is loaded from sensor
  */
 bool Sensors::pmSensorRead() {
+    if (uart_main_stream) {
+        bool ready = uartSlotPublish(&uart_main);
+        if (!ready) DEBUG("-->[SLIB] UART without new frames");
+        return ready;
+    }
     switch (dev_uart_type) {
         case Auto:
             return pmGenericRead();
@@ -551,142 +1284,189 @@ void Sensors::am2320Read() {
     if (status != AM232X_OK) return;
     float humi1 = am2320.getHumidity();
     float temp1 = am2320.getTemperature();
-    if (!isnan(humi1)) humi = humi1;
+    if (!isnan(humi1)) unitPublish<HUM>(humi1);
     if (!isnan(temp1)) {
-        temp = temp1-toffset;
+        unitPublish<TEMP>(temp1);
         dataReady = true;
         DEBUG("-->[SLIB] AM2320 read > done!");
-        unitRegister(UNIT::TEMP);
-        unitRegister(UNIT::HUM);
     }
 }
 
-void Sensors::bme280Read() {
-    float humi1 = bme280.readHumidity();
-    float temp1 = bme280.readTemperature();
+void Sensors::bme280Read(SensorInstance &instance) {
+    Adafruit_BME280 *bme = instance.device.bme280;
+    if (measure_profile == PROFILE_LOW_POWER && !bme->takeForcedMeasurement()) return;
+    float humi1 = bme->readHumidity();
+    float temp1 = bme->readTemperature();
     if (isnan(humi1) || humi1 == 0 || isnan(temp1)) return; 
-    humi = humi1;
-    temp = temp1-toffset;
-    pres = bme280.readPressure();
-    alt = bme280.readAltitude(SEALEVELPRESSURE_HPA);
+    unitPublish<HUM>(humi1);
+    unitPublish<TEMP>(temp1);
+    float press1 = bme->readPressure();
+    unitPublish<PRESS>(press1);
+    if (current_source < DRIVERS_MAX) pressureUpdate(toSValue(press1) / 100);
+    unitPublish<ALT>(bme->readAltitude(SEALEVELPRESSURE_HPA));
     dataReady = true;
     DEBUG("-->[SLIB] BME280 read > done!");
-    unitRegister(UNIT::TEMP);
-    unitRegister(UNIT::HUM);
 }
 
 void Sensors::bmp280Read() {
+    if (measure_profile == PROFILE_LOW_POWER && !bmp280.takeForcedMeasurement()) return;
     float temp1 = bmp280.readTemperature();
     float press1 = bmp280.readPressure();
     if (press1 == 0) return;
-    temp = temp1-toffset;
-    pres = bmp280.readPressure();
-    alt = bmp280.readAltitude(SEALEVELPRESSURE_HPA);
+    unitPublish<TEMP>(temp1);
+    unitPublish<PRESS>(press1);
+    pressureUpdate(toSValue(press1) / 100);
+    unitPublish<ALT>(bmp280.readAltitude(SEALEVELPRESSURE_HPA));
     dataReady = true;
     DEBUG("-->[SLIB] BMP280 read > done!");
-    unitRegister(UNIT::TEMP);
-    unitRegister(UNIT::PRESS);
-    unitRegister(UNIT::ALT);
 }
 
+/**
+ * BME680 split-phase read. The conversion (and the gas heater) is started
+ * BME680_LEAD_TIME before the sample round (its driver lead time), then
+ * here it only waits the remaining conversion time. If loop() was not
+ * called on the lead time it is started here, and collected on this round
+ * after a wait bounded by the lead time (else on the next round).
+ */
 void Sensors::bme680Read() {
-    unsigned long endTime = bme680.beginReading();
-    if (endTime == 0) return;
-    if (!bme680.endReading()) return;
+    if (bme680_end == 0 && !bme680_ready) bme680Start();
+    if (bme680_end != 0) {
+        if ((int32_t)(bme680_end - millis()) > BME680_LEAD_TIME) {
+            driverUnitsKeep();  // pending conversion, it isn't a failure
+            return;
+        }
+        bme680Collect();  // it waits only the remaining time
+    }
+    if (!bme680_ready) return;
+    bme680_ready = false;
 
     float temp1 = bme680.temperature;
 
     if (temp1 != 0) {
-        temp = temp1-toffset;
-        humi = bme680.humidity;
-        pres = bme680.pressure / 100.0;
-        gas  = bme680.gas_resistance / 1000.0;
-        alt  = bme680.readAltitude(SEALEVELPRESSURE_HPA);
+        unitPublish<TEMP>(temp1);
+        unitPublish<HUM>(bme680.humidity);
+        unitPublish<PRESS>(bme680.pressure / 100.0);
+        pressureUpdate(toSValue(bme680.pressure) / 100);
+        if (measure_profile != PROFILE_LOW_POWER) unitPublish<GAS>(bme680.gas_resistance / 1000.0);  // gas heater is off
+        // readAltitude() makes a new blocking conversion, it is calculated from the last pressure
+        unitPublish<ALT>(44330.0 * (1.0 - pow(bme680.pressure / 100.0 / SEALEVELPRESSURE_HPA, 0.1903)));
 
         dataReady = true;
         DEBUG("-->[SLIB] BME680 read > done!");
-        unitRegister(UNIT::TEMP);
-        unitRegister(UNIT::HUM);
-        unitRegister(UNIT::PRESS);
-        unitRegister(UNIT::GAS);
     }
 }
 
+bool Sensors::bme680Start() {
+    if (bme680_end != 0 || bme680_ready) return true;  // running or collected
+    unsigned long end = bme680.beginReading();
+    if (end == 0) return false;
+    bme680_end = end;
+    return true;
+}
+
+void Sensors::bme680Collect() {
+    bme680_ready = bme680.endReading();
+    bme680_end = 0;
+}
+
+/**
+ * SHT31 single shot with low repeatability, without clock stretching
+ * (4 ms of conversion instead of 15 ms). Adafruit_SHT31 only has the high
+ * repeatability, it is sent with the BusIO device of its bus and address.
+ */
+bool Sensors::sht31ReadLowRep(SensorInstance &instance, float *temperature, float *humidity) {
+    Adafruit_I2CDevice device(instance.address, instance.bus);
+    static const uint8_t command[] = {0x24, 0x16};
+    if (!device.write(command, sizeof(command))) return false;
+    delay(5);
+    uint8_t data[6];
+    if (!device.read(data, sizeof(data))) return false;
+    if (sensirionCRC(data, 2) != data[2] || sensirionCRC(data + 3, 2) != data[5]) return false;
+    *temperature = -45.0 + 175.0 * (data[0] << 8 | data[1]) / 65535.0;
+    *humidity = 100.0 * (data[3] << 8 | data[4]) / 65535.0;
+    return true;
+}
+
 void Sensors::aht10Read() {
     float humi1 = aht10.readHumidity();
     float temp1 = aht10.readTemperature();
-    if (humi1 != 255) humi = humi1;
+    if (humi1 != 255) unitPublish<HUM>(humi1);
     if (temp1 != 255) {
-        temp = temp1-toffset;
+        unitPublish<TEMP>(temp1);
         dataReady = true;
         DEBUG("-->[SLIB] AHT10 read > done!");
-        unitRegister(UNIT::TEMP);
-        unitRegister(UNIT::HUM);
     }
 }
 
-void Sensors::sht31Read() {
-    float humi1 = sht31.readHumidity();
-    float temp1 = sht31.readTemperature();
-    if (!isnan(humi1)) humi = humi1;
+void Sensors::sht31Read(SensorInstance &instance) {
+    float humi1 = NAN, temp1 = NAN;
+    if (measure_profile == PROFILE_LOW_POWER || measure_profile == PROFILE_LOW_LATENCY)
+        sht31ReadLowRep(instance, &temp1, &humi1);
+    else
+        instance.device.sht31->readBoth(&temp1, &humi1);  // one measurement for both
+    if (!isnan(humi1)) unitPublish<HUM>(humi1);
     if (!isnan(temp1)) { 
-        temp = temp1-toffset;
+        unitPublish<TEMP>(temp1);
         dataReady = true;
         DEBUG("-->[SLIB] SHT31 read > done!");
-        unitRegister(UNIT::TEMP);
-        unitRegister(UNIT::HUM);
     }
 }
 
-void Sensors::CO2scd30Read() {
-    uint16_t tCO2 = scd30.getCO2();  // we need temp var, without it override CO2
+void Sensors::CO2scd30Read(SensorInstance &instance) {
+    SCD30 *scd = instance.device.scd30;
+    if (current_source < DRIVERS_MAX) CO2PressurePush();
+    if (!scd->dataAvailable() || !scd->readMeasurement()) {  // each measurement is read once
+        driverUnitsKeep();
+        return;
+    }
+    uint16_t tCO2 = scd->getCO2();  // we need temp var, without it override CO2
     if (tCO2 > 0) {
-        CO2Val = tCO2;
-        CO2humi = scd30.getHumidity();
-        CO2temp = scd30.getTemperature();
+        CO2Process(tCO2, false);
+        unitPublish<CO2HUM>(scd->getHumidity());
+        unitPublish<CO2TEMP>(scd->getTemperature());
         dataReady = true;
         DEBUG("-->[SLIB] SCD30 read > done!");
-        unitRegister(UNIT::CO2);
-        unitRegister(UNIT::CO2TEMP);
-        unitRegister(UNIT::CO2HUM);
     }
 }
 
-void Sensors::CO2scd4xRead()
+void Sensors::CO2scd4xRead(SensorInstance &instance)
 {
+    SensirionI2CScd4x *scd = instance.device.scd4x;
     uint16_t error = 0;
-    char errorMessage[256];
     uint16_t tCO2 = 0;
     float tCO2temp, tCO2humi = 0; // we need temp vars, without it override values
-    if (getMainDeviceSelected() != "SCD4x") return;
-    error = scd4x.readMeasurement(tCO2, tCO2temp, tCO2humi);
+    if (current_source < DRIVERS_MAX) CO2PressurePush();
+    uint16_t ready = 0;
+    error = scd->getDataReadyStatus(ready);
+    if (!error && (ready & 0x07FF) == 0) {  // without new measurement (5s period)
+        driverUnitsKeep();
+        return;
+    }
+    if (!error) error = scd->readMeasurement(tCO2, tCO2temp, tCO2humi);
     if (error) {
-        DEBUG("[E][SLIB] SCD4x Error reading measurement\t: ", String(error).c_str());
-        errorToString(error, errorMessage, 256);
-        DEBUG("[E][SLIB] SCD4x msg\t: ", errorMessage);
+        if (devmode) {
+            char errorMessage[256];
+            DEBUG("[E][SLIB] SCD4x Error reading measurement\t: ", String(error).c_str());
+            errorToString(error, errorMessage, 256);
+            DEBUG("[E][SLIB] SCD4x msg\t: ", errorMessage);
+        }
         return;
     } else {
-        CO2Val = tCO2;
-        CO2humi = tCO2humi;
-        CO2temp = tCO2temp;
+        CO2Process(tCO2, false);
+        unitPublish<CO2HUM>(tCO2humi);
+        unitPublish<CO2TEMP>(tCO2temp);
+        if (instance.mode == SCD4X_MODE_SINGLE_SHOT) scd4xMeasurementStart(instance);  // next single shot
         dataReady = true;
         DEBUG("-->[SLIB] SCD4x read > done!");
-        unitRegister(UNIT::CO2);
-        unitRegister(UNIT::CO2TEMP);
-        unitRegister(UNIT::CO2HUM);
     }
 }
 
 void Sensors::PMGCJA5Read() {
-    if (!getMainDeviceSelected().equals("PANASONIC_I2C")) return;
-    pm1 = pmGCJA5.getPM1_0();
-    pm25 = pmGCJA5.getPM2_5();
-    pm10 = pmGCJA5.getPM10();
+    unitPublish<PM1>(pmGCJA5.getPM1_0());
+    unitPublish<PM25>(pmGCJA5.getPM2_5());
+    unitPublish<PM10>(pmGCJA5.getPM10());
     dataReady = true;
     DEBUG("-->[SLIB] GCJA5 read > done!");
-    unitRegister(UNIT::PM1);
-    unitRegister(UNIT::PM25);
-    unitRegister(UNIT::PM10);
 }
 
 bool Sensors::dhtIsReady(float *temperature, float *humidity) {
@@ -707,17 +1487,114 @@ void Sensors::setDHTparameters(int dht_sensor_pin, int dht_sensor_type) {
     DHT_nonblocking dht_sensor(DHT_SENSOR_PIN, DHT_SENSOR_TYPE);
 }
 
+/// DHT2x polling, on each loop() on its lead time until it has a sample
+bool Sensors::dhtStart() {
+    if (!dht_ready) dht_ready = dhtIsReady(&dhttemp, &dhthumi);
+    return dht_ready;
+}
+
 void Sensors::dhtRead() {
-    if (dhtIsReady(&dhttemp, &dhthumi) == true) {
-        temp = dhttemp-toffset;
-        humi = dhthumi;
-        dataReady = true; 
-        DEBUG("-->[SLIB] DHTXX read > done!");
-        unitRegister(UNIT::TEMP);
-        unitRegister(UNIT::HUM);
+    if (!dht_ready) return;  // without a sample on its lead time
+    dht_ready = false;
+    unitPublish<TEMP>(dhttemp);
+    unitPublish<HUM>(dhthumi);
+    dataReady = true; 
+    DEBUG("-->[SLIB] DHTXX read > done!");
+}
+
+/// one pass of the pipeline of a built-in unit, by its runtime value (runtime units are not processed)
+svalue_t Sensors::unitProcess(UNIT unit, svalue_t value) {
+    switch (unit) {
+#define X(unit, symbol, name, scale, slot) \
+    case unit:                             \
+        return UnitPipelineStorage<unit>::pipeline.process(value);
+        SENSOR_UNITS
+#undef X
+        default:
+            return value;
     }
 }
 
+/// temperature of the current source, the instances are only sources of the fusion (without FUSION_LAST)
+void Sensors::setSourceTemperature(svalue_t temperature) {
+    if (current_source < DRIVERS_MAX || current_source >= SOURCES_MAX) temp = temperature;
+    if (current_source >= SOURCES_MAX) return;
+    source_temp[current_source] = temperature;
+    source_temp_time[current_source] = millis();
+    source_temp_mask |= (1UL << current_source);
+}
+
+void Sensors::setSourceHumidity(svalue_t humidity) {
+    if (current_source < DRIVERS_MAX || current_source >= SOURCES_MAX) humi = humidity;
+    if (current_source >= SOURCES_MAX) return;
+    source_humi[current_source] = humidity;
+    source_humi_time[current_source] = millis();
+    source_humi_mask |= (1UL << current_source);
+}
+
+/**
+ * The last sample of a source is kept across rounds (i.e. a DHT without a
+ * sample on this round), and it is fused up to SOURCE_FRESH_PERIODS sample
+ * periods of its driver.
+ */
+bool Sensors::isSourceFresh(int source, uint32_t time) {
+    uint32_t period = adaptive_sampling && driver_interval[source] > 0 ? driver_interval[source] : sample_time * 1000UL;
+    const DriverOps *ops = sourceOps(source);
+    if (ops != nullptr && ops->period * 1000UL > period) period = ops->period * 1000UL;
+    return millis() - time <= SOURCE_FRESH_PERIODS * period;
+}
+
+/// weighted mean or median of the fresh sources on the mask, false without sources
+bool Sensors::sourcesFusion(svalue_t *values, uint32_t *times, uint32_t mask, svalue_t *fused) {
+    svalue_t sorted[SOURCES_MAX];
+    saccum_t sum = 0;
+    uint32_t weights = 0;
+    int count = 0;
+    for (int i = 0; i < SOURCES_MAX; i++) {
+        uint16_t weight = (source_weight_set & (1UL << i)) ? source_weight[i] : SOURCE_WEIGHT_ONE;
+        if (!(mask & (1UL << i)) || weight == 0 || !isSourceFresh(i, times[i])) continue;
+        sum += (saccum_t)values[i] * weight;
+        weights += weight;
+        int j = count++;
+        for (; j > 0 && sorted[j - 1] > values[i]; j--) sorted[j] = sorted[j - 1];
+        sorted[j] = values[i];
+    }
+    if (count == 0) return false;
+    if (th_fusion == FUSION_MEAN)
+        *fused = sum / weights;
+    else if (count % 2)
+        *fused = sorted[count / 2];
+    else
+        *fused = (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+    return true;
+}
+
+/// published temperature and humidity from the fresh samples of all sources
+void Sensors::thFusion() {
+    if (th_fusion == FUSION_LAST) return;
+    svalue_t fused;
+    if (sourcesFusion(source_temp, source_temp_time, source_temp_mask, &fused)) temp = fused;
+    if (sourcesFusion(source_humi, source_humi_time, source_humi_mask, &fused)) humi = fused;
+}
+
+/// PM humidity correction with the humidity of the same sample round
+void Sensors::pmHumidityCorrection() {
+    if (!pm_humi_correction) return;
+    svalue_t rh;
+    if (isUnitRegistered(HUM)) rh = humi;
+    else if (isUnitRegistered(CO2HUM)) rh = CO2humi;
+    else return;
+    uint16_t factor = pm_humi_lut[(int)constrain(rh / SVALUE_SCALE, 0, PM_LUT_RH_MAX)];
+    pm1c = ((uint32_t)pm1 * factor) >> 15;
+    pm25c = ((uint32_t)pm25 * factor) >> 15;
+    pm4c = ((uint32_t)pm4 * factor) >> 15;
+    pm10c = ((uint32_t)pm10 * factor) >> 15;
+    if (isUnitRegistered(PM1)) unitRegister(PM1C);
+    if (isUnitRegistered(PM25)) unitRegister(PM25C);
+    if (isUnitRegistered(PM4)) unitRegister(PM4C);
+    if (isUnitRegistered(PM10)) unitRegister(PM10C);
+}
+
 void Sensors::onSensorError(const char *msg) {
     DEBUG(msg);
     if (_onErrorCb != nullptr ) _onErrorCb(msg);
@@ -747,10 +1624,14 @@ void Sensors::sps30Errorloop(char *mess, uint8_t r) {
  * @param pms_tx PMS TX pin.
  **/
 bool Sensors::sensorSerialInit(int pms_type, int pms_rx, int pms_tx) {
+    // sniffing baud rate and framing, it configures the UART only once
+    if (uart_autobaud && pms_type == Auto && uartAutoBaud(pms_type, pms_rx, pms_tx)) return true;
+
     // set UART for autodetection sensors (Honeywell, Plantower)
     if (pms_type == Auto) {
         DEBUG("-->[SLIB] UART detecting type\t: Auto");
         if (!serialInit(pms_type, 9600, pms_rx, pms_tx)) return false;
+        if (uartFastDetectInit()) return true;
     }
     // set UART for custom sensors
     else if (pms_type == Panasonic) {
@@ -785,6 +1666,226 @@ bool Sensors::sensorSerialInit(int pms_type, int pms_rx, int pms_tx) {
 
     return false;
 }
+/**
+ * @brief Concurrent UART autodetection in a single listening window.
+ * 
+ * The CO2 sensors are probed with its read command in one short sequence,
+ * and the frame matchers of all sensors run in parallel over the same
+ * byte stream. The first valid frame (header and checksum) wins.
+ * @return UART sensor type detected, -1 if any
+ **/
+int Sensors::uartFastDetect() {
+    FrameDetector detector;
+
+    _serial->write(mhz19_read_cmd, sizeof(mhz19_read_cmd));
+    delay(UART_DETECT_PROBE_GAP);
+    _serial->write(cm1106_read_cmd, sizeof(cm1106_read_cmd));
+    delay(UART_DETECT_PROBE_GAP);
+    _serial->write(s8_read_cmd, sizeof(s8_read_cmd));
+
+    uint32_t start = millis();
+    while (millis() - start < UART_DETECT_WINDOW) {
+        while (_serial->available() > 0) {
+            FRAME_TYPE frame = detector.push(_serial->read());
+            if (frame != FRAME_NONE) {
+                DEBUG("-->[SLIB] UART frame detected (ms)\t: ", String(millis() - start).c_str());
+                return uartTypeFromFrame(frame);
+            }
+        }
+        delay(1);
+    }
+    return -1;
+}
+
+/**
+ * UART sensor selection from the concurrent autodetection.
+ * @return true if any UART sensor was detected
+ */
+bool Sensors::uartFastDetectInit() {
+    return uartSensorSelect(uartFastDetect());
+}
+
+/**
+ * UART sensor selection after a detection with a valid frame.
+ * @return true if the sensor was selected
+ */
+bool Sensors::uartSensorSelect(int type) {
+    switch (type) {
+        case Auto:
+        case Panasonic:
+        case SDS011:
+            break;
+        case SSPS30:
+            if (!sps30UARTInit()) return false;
+            break;
+        case Mhz19:
+            if (!CO2Mhz19Init()) return false;
+            break;
+        case CM1106:
+            if (!CO2CM1106Init()) return false;
+            break;
+        case SENSEAIRS8:
+            if (!senseAirS8Init()) return false;
+            break;
+        default:
+            DEBUG("-->[SLIB] UART fast detection failed, trying legacy detection..");
+            return false;
+    }
+    device_selected = uartDeviceName(type);
+    dev_uart_type = type;
+    DEBUG("-->[SLIB] UART sensor detected\t: ", device_selected.c_str());
+    return true;
+}
+
+/// main device name of each UART sensor type
+const char *Sensors::uartDeviceName(int type) {
+    static const char *const names[] = {"GENERIC", "PANASONIC", "SENSIRION", "SDS011", "MHZ19", "CM1106", "SENSEAIRS8"};
+    return type >= Auto && type <= SENSEAIRS8 ? names[type] : "";
+}
+
+/**
+ * Bounded UART probe when the detection cache has not a UART sensor, only
+ * one listening window: a sensor connected later is found without the full
+ * detection on each boot.
+ */
+bool Sensors::sensorSerialProbe(int pms_type, int pms_rx, int pms_tx) {
+    if (pms_type == SSPS30) return serialInit(pms_type, 115200, pms_rx, pms_tx) && uartSensorSelect(SSPS30);
+    if (!serialInit(pms_type, 9600, pms_rx, pms_tx)) return false;
+    return uartFastDetectInit();
+}
+
+int Sensors::uartTypeFromFrame(FRAME_TYPE frame) {
+    switch (frame) {
+        case FRAME_PMS:
+            return Auto;
+        case FRAME_PANASONIC:
+            return Panasonic;
+        case FRAME_SDS011:
+            return SDS011;
+        case FRAME_MHZ19:
+            return Mhz19;
+        case FRAME_CM1106:
+            return CM1106;
+        case FRAME_S8:
+            return SENSEAIRS8;
+        case FRAME_SHDLC:
+            return SSPS30;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief UART baud rate and framing detection.
+ * 
+ * The line is sampled on each candidate (9600 8N1, 9600 8E1, 115200 8N1)
+ * with the probe commands of its sensors, and the recorded stream is
+ * scored by valid headers and checksums (see frameScore()), only the
+ * candidates with a valid frame score. The UART is configured with the
+ * best candidate and its sensor is selected.
+ * @return true if a sensor was detected and selected
+ */
+bool Sensors::uartAutoBaud(int pms_type, int pms_rx, int pms_tx) {
+    const uint32_t bauds[] = {9600, 9600, 115200};
+    const uint32_t configs[] = {SERIAL_8N1, SERIAL_8E1, SERIAL_8N1};
+    uint8_t buf[UART_SNIFF_BUFFER];
+    int best = -1, best_score = 0;
+    FRAME_TYPE best_frame = FRAME_NONE;
+
+    for (int i = 0; i < 3; i++) {
+        uart_config = configs[i];
+        if (!serialInit(pms_type, bauds[i], pms_rx, pms_tx)) return false;
+        while (_serial->available() > 0) _serial->read();
+        if (bauds[i] == 115200) {
+            _serial->write(shdlc_info_cmd, sizeof(shdlc_info_cmd));
+        } else {
+            _serial->write(mhz19_read_cmd, sizeof(mhz19_read_cmd));
+            delay(UART_DETECT_PROBE_GAP);
+            _serial->write(cm1106_read_cmd, sizeof(cm1106_read_cmd));
+            delay(UART_DETECT_PROBE_GAP);
+            _serial->write(s8_read_cmd, sizeof(s8_read_cmd));
+        }
+        size_t len = 0;
+        uint32_t start = millis();
+        while (len < UART_SNIFF_BUFFER && millis() - start < UART_SNIFF_WINDOW) {
+            while (_serial->available() > 0 && len < UART_SNIFF_BUFFER) buf[len++] = _serial->read();
+            delay(1);
+        }
+        FRAME_TYPE frame;
+        int score = frameScore(buf, len, &frame);
+        if (devmode) Serial.printf("-->[SLIB] UART sniff %lu cfg:0x%lx\t: %i bytes score %i\n",
+                                   (unsigned long)bauds[i], (unsigned long)configs[i], (int)len, score);
+        if (score > best_score) {
+            best = i;
+            best_score = score;
+            best_frame = frame;
+        }
+    }
+
+    if (best < 0) {
+        uart_config = SERIAL_8N1;
+        DEBUG("-->[SLIB] UART sniffer without valid frames");
+        return false;
+    }
+    uart_config = configs[best];
+    if (best != 2 && !serialInit(pms_type, bauds[best], pms_rx, pms_tx)) return false;
+    return uartSensorSelect(uartTypeFromFrame(best_frame));
+}
+
+/**
+ * UART sensor init from the detection cache, it is validated only with
+ * one probe of the cached sensor.
+ * @return true if the cached sensor answered
+ */
+bool Sensors::sensorSerialCachedInit(SensorsCache *cache) {
+    DEBUG("-->[SLIB] UART cached type\t: ", uartDeviceName(cache->uart_type));
+    if (!serialInit(cache->uart_type, cache->uart_baud, cache->pms_rx, cache->pms_tx)) return false;
+    bool probe = false;
+    switch (cache->uart_type) {
+        case Auto:
+            probe = waitSerialData(32, DETECTION_CACHE_TIMEOUT) && pmGenericRead();
+            break;
+        case Panasonic:
+            probe = waitSerialData(32, DETECTION_CACHE_TIMEOUT) && pmPanasonicRead();
+            break;
+        case SDS011:
+            probe = waitSerialData(10, DETECTION_CACHE_TIMEOUT) && pmSDS011Read();
+            break;
+        case SSPS30:
+            probe = sps30UARTInit();
+            break;
+        case Mhz19:
+            probe = CO2Mhz19Init() && CO2Mhz19Read();
+            break;
+        case CM1106:
+            probe = CO2CM1106Init();
+            break;
+        case SENSEAIRS8:
+            probe = senseAirS8Init();
+            break;
+        default:
+            break;
+    }
+    if (!probe) {
+        DEBUG("[W][SLIB] UART cached sensor not found, starting detection..");
+        return false;
+    }
+    device_selected = uartDeviceName(cache->uart_type);  // I2C sensors set the main device after it
+    dev_uart_type = cache->uart_type;
+    DEBUG("-->[SLIB] UART sensor detected\t: ", device_selected.c_str());
+    return true;
+}
+
+/// wait until the UART has a full frame or the timeout is reached
+bool Sensors::waitSerialData(unsigned int lenght_buffer, uint32_t timeout) {
+    uint32_t start = millis();
+    while (_serial->available() < (int)lenght_buffer) {
+        if (millis() - start > timeout) return false;
+        delay(10);
+    }
+    return true;
+}
+
 /**
  * @brief Generic PM sensor auto detection. 
  * 
@@ -796,7 +1897,7 @@ bool Sensors::pmSensorAutoDetect(int pms_type) {
 
     if (pms_type == SSPS30) {
         if (sps30UARTInit()) {
-            device_selected = "SENSIRION";
+            device_selected = uartDeviceName(SSPS30);
             dev_uart_type = SSPS30;
             return true;
         }
@@ -804,7 +1905,7 @@ bool Sensors::pmSensorAutoDetect(int pms_type) {
 
     if (pms_type == SDS011) {
         if (pmSDS011Read()) {
-            device_selected = "SDS011";
+            device_selected = uartDeviceName(SDS011);
             dev_uart_type = SDS011;
             return true;
         }
@@ -812,7 +1913,7 @@ bool Sensors::pmSensorAutoDetect(int pms_type) {
 
     if (pms_type == Mhz19) {
         if (CO2Mhz19Init()) {
-            device_selected = "MHZ19";
+            device_selected = uartDeviceName(Mhz19);
             dev_uart_type = Mhz19;
             return true;
         }
@@ -820,7 +1921,7 @@ bool Sensors::pmSensorAutoDetect(int pms_type) {
 
     if (pms_type == CM1106) {
         if (CO2CM1106Init()) {
-            device_selected = "CM1106";
+            device_selected = uartDeviceName(CM1106);
             dev_uart_type = CM1106;
             return true;
         }
@@ -828,7 +1929,7 @@ bool Sensors::pmSensorAutoDetect(int pms_type) {
 
     if (pms_type == SENSEAIRS8) {
         if (senseAirS8Init()) {
-            device_selected = "SENSEAIRS8";
+            device_selected = uartDeviceName(SENSEAIRS8);
             dev_uart_type = SENSEAIRS8;
             return true;
         }
@@ -836,13 +1937,13 @@ bool Sensors::pmSensorAutoDetect(int pms_type) {
 
     if (pms_type <= Panasonic) {
         if (pmGenericRead()) {
-            device_selected = "GENERIC";
+            device_selected = uartDeviceName(Auto);
             dev_uart_type = Auto;
             return true;
         }
         delay(1000);  // sync serial
         if (pmPanasonicRead()) {
-            device_selected = "PANASONIC";
+            device_selected = uartDeviceName(Panasonic);
             dev_uart_type = Panasonic;
             return true;
         }
@@ -860,6 +1961,7 @@ bool Sensors::CO2Mhz19Init() {
 
 bool Sensors::CO2CM1106Init() {
     DEBUG("-->[SLIB] CM1106 starting CM1106 sensor..");
+    delete cm1106;  // cached probes and init retries, it could be on other serial port
     cm1106 = new CM1106_UART(*_serial);
 
     // Check if CM1106 is available
@@ -906,6 +2008,7 @@ bool Sensors::CO2CM1106Init() {
 }
 
 bool Sensors::senseAirS8Init() {
+    delete s8;  // cached probes and init retries, it could be on other serial port
     s8 = new S8_UART(*_serial);
     // Check if S8 is available
     s8->get_firmware_version(s8sensor.firm_version);
@@ -968,7 +2071,7 @@ bool Sensors::sps30UARTInit() {
 }
 
 bool Sensors::sps30I2CInit() {
-    if (dev_uart_type == SSPS30) return false;
+    if (uart_detected && dev_uart_type == SSPS30) return false;  // it is on the UART
     
     DEBUG("-->[SLIB] I2C SPS30 starting sensor..");
     // set driver debug level
@@ -986,9 +2089,7 @@ bool Sensors::sps30I2CInit() {
     // start measurement
     if (sps30.start()) {
         DEBUG("-->[SLIB] SPS30 Measurement OK");
-        Serial.println("-->[SLIB] I2C sensor detected\t: SPS30");
-        device_selected = "SENSIRION";
-        dev_uart_type = SSPS30; // TODO: it isn't a uart, but it's a uart-like device
+        if (!uart_detected) dev_uart_type = SSPS30; // TODO: it isn't a uart, but it's a uart-like device
         if (sps30.I2C_expect() == 4)
             DEBUG("[E][SLIB] SPS30 due to I2C buffersize only PM values  \n");
         return true;
@@ -1062,85 +2163,76 @@ void Sensors::sps30DeviceInfo() {
     DEBUG("-->[SLIB] SPS30 Library level\t: ", buf);
 }
 
-void Sensors::am2320Init() {
+bool Sensors::am2320Init() {
     DEBUG("-->[SLIB] AM2320 starting AM2320 sensor..");
-    if (am2320.begin()) Serial.println("-->[SLIB] I2C sensor detected\t: AM2320");
+    return am2320.begin();
 }
 
-void Sensors::sht31Init() {
+bool Sensors::sht31Init(SensorInstance &instance) {
     DEBUG("-->[SLIB] SHT31 starting SHT31 sensor..");
-    sht31 = Adafruit_SHT31();
-    if (sht31.begin()) Serial.println("-->[SLIB] I2C sensor detected\t: SHT31");
+    return instance.device.sht31->begin(instance.address);
 }
 
-void Sensors::bme280Init() {
+bool Sensors::bme280Init(SensorInstance &instance) {
     DEBUG("-->[SLIB] BME280 starting BME280 sensor..");
-    if (bme280.begin()) Serial.println("-->[SLIB] I2C sensor detected\t: BME280");
+    if (!instance.device.bme280->begin(instance.address, instance.bus)) return false;
+    profileApply(instance);
+    return true;
 }
 
-void Sensors::bmp280Init() {
+bool Sensors::bmp280Init() {
     DEBUG("-->[SLIB] BMP280 starting BMP280 sensor..");
-    if (!bmp280.begin() && !bmp280.begin(BMP280_ADDRESS_ALT)) return;
-    Serial.println("-->[SLIB] I2C sensor detected\t: BMP280");
-    // Default settings from datasheet.
-    bmp280.setSampling(Adafruit_BMP280::MODE_NORMAL,  // Operating Mode.
-                    Adafruit_BMP280::SAMPLING_X2,     // Temp. oversampling
-                    Adafruit_BMP280::SAMPLING_X16,    // Pressure oversampling
-                    Adafruit_BMP280::FILTER_X16,      // Filtering.
-                    Adafruit_BMP280::STANDBY_MS_500); // Standby time.
+    if (!bmp280.begin() && !bmp280.begin(BMP280_ADDRESS_ALT)) return false;
+    profileApply(sources[DRIVER_BMP280]);
     Adafruit_Sensor *bmp_temp = bmp280.getTemperatureSensor();
     Adafruit_Sensor *bmp_pressure = bmp280.getPressureSensor();
     if(devmode) bmp_temp->printSensorDetails();
     if(devmode) bmp_pressure->printSensorDetails();
+    return true;
 }
 
-void Sensors::bme680Init() {
+bool Sensors::bme680Init() {
     DEBUG("-->[SLIB] BME680 starting BME680 sensor..");
-    if (!bme680.begin()) return;
-    Serial.println("-->[SLIB] I2C sensor detected\t: BME680");
-    bme680.setTemperatureOversampling(BME680_OS_8X);
-    bme680.setHumidityOversampling(BME680_OS_2X);
-    bme680.setPressureOversampling(BME680_OS_4X);
-    bme680.setIIRFilterSize(BME680_FILTER_SIZE_3);
-    bme680.setGasHeater(320, 150);  // 320*C for 150 ms
+    if (!bme680.begin() && !bme680.begin(0x76)) return false;
+    profileApply(sources[DRIVER_BME680]);
     DEBUG("-->[SLIB] BME680 set sea level pressure\t: ", String(SEALEVELPRESSURE_HPA).c_str());
+    return true;
 }
 
-void Sensors::aht10Init() {
+bool Sensors::aht10Init() {
     DEBUG("-->[SLIB] AHT10 starting AHT10 sensor..");
     aht10 = AHT10(AHT10_ADDRESS_0X38);
-    if (aht10.begin()) Serial.println("-->[SLIB] I2C sensor detected\t: AHT10");
+    return aht10.begin();
 }
 
-void Sensors::CO2scd30Init() {
+bool Sensors::CO2scd30Init(SensorInstance &instance) {
     DEBUG("-->[SLIB] SCD30 starting CO2 SCD30 sensor..");
-    if (!scd30.begin()) return;
-    Serial.println("-->[SLIB] I2C sensor detected\t: SCD30");
+    SCD30 *scd = instance.device.scd30;
+    if (!scd->begin(*instance.bus)) return false;
     delay(10);
 
-    device_selected = "SCD30";  // TODO: sync this constants with app
-
-    DEBUG("-->[SLIB] SCD30 current temp offset\t: ",String(scd30.getTemperatureOffset()).c_str());
-    DEBUG("-->[SLIB] SCD30 current altitude offset\t: ", String(scd30.getAltitudeCompensation()).c_str());
+    DEBUG("-->[SLIB] SCD30 current temp offset\t: ",String(scd->getTemperatureOffset()).c_str());
+    DEBUG("-->[SLIB] SCD30 current altitude offset\t: ", String(scd->getAltitudeCompensation()).c_str());
 
-    if(scd30.getAltitudeCompensation() != uint16_t(altoffset)){
+    if(scd->getAltitudeCompensation() != uint16_t(altoffset)){
         DEBUG("-->[SLIB] SCD30 updated altitude offset to\t: ", String(altoffset).c_str());
-        setSCD30AltitudeOffset(altoffset);
+        scd->setAltitudeCompensation(uint16_t(altoffset));
         delay(10);
     }
 
-    if(uint16_t((scd30.getTemperatureOffset()*100)) != (uint16_t(toffset*100))) {
-        setSCD30TempOffset(toffset);
+    if(uint16_t((scd->getTemperatureOffset()*100)) != (uint16_t(toffset*100))) {
+        Serial.println("-->[SLIB] SCD30 new temperature offset\t: " + String(toffset));
+        scd->setTemperatureOffset(toffset);
         delay(10);
     }
 
-    CO2scd30Read();
-
+    CO2scd30Read(instance);
+    return true;
 }
 
 /// set SCD30 temperature compensation
 void Sensors::setSCD30TempOffset(float offset) {
-    if (getMainDeviceSelected().equals("SCD30")) {
+    if (main_driver == DRIVER_SCD30) {
         Serial.println("-->[SLIB] SCD30 new temperature offset\t: " + String(offset));
         scd30.setTemperatureOffset(offset);
     }
@@ -1148,102 +2240,288 @@ void Sensors::setSCD30TempOffset(float offset) {
 
 /// set SCD30 altitude compensation
 void Sensors::setSCD30AltitudeOffset(float offset) {
-    if (getMainDeviceSelected().equals("SCD30")) {
+    if (main_driver == DRIVER_SCD30) {
         Serial.println("-->[SLIB] SCD30 new altitude offset\t: " + String(offset));
         scd30.setAltitudeCompensation(uint16_t(offset));
     }
 }
 
-void Sensors::CO2scd4xInit() {
+bool Sensors::CO2scd4xInit(SensorInstance &instance) {
     DEBUG("-->[SLIB] SCD4x starting CO2 SCD4x sensor..");
+    SensirionI2CScd4x *scd = instance.device.scd4x;
     float tTemperatureOffset, offsetDifference;
     uint16_t tSensorAltitude;
     uint16_t error;
     char errorMessage[256];
-    scd4x.begin(Wire);
-    error = scd4x.stopPeriodicMeasurement();
+    scd->begin(*instance.bus);
+    error = scd->stopPeriodicMeasurement();
     if (error) {
         DEBUG("[E][SLIB] SCD4x stopping periodic error\t: ", String(error).c_str());
         errorToString(error, errorMessage, 256);
         DEBUG("[E][SLIB] SCD4x error msg\t:", errorMessage);
-        return;
-    } else {
-        Serial.println("-->[SLIB] I2C sensor detected\t: SCD4x");
-        delay(10);
+        return false;
     }
+    delay(10);
 
-    device_selected = "SCD4x";  // TODO: sync this constants with app
-
-    scd4x.getTemperatureOffset(tTemperatureOffset);
-    scd4x.getSensorAltitude(tSensorAltitude);
+    scd->getTemperatureOffset(tTemperatureOffset);
+    scd->getSensorAltitude(tSensorAltitude);
     DEBUG("-->[SLIB] SCD4x current temperature offset\t: ", String(tTemperatureOffset).c_str());
     DEBUG("-->[SLIB] SCD4x current altitude offset\t: ", String(tSensorAltitude).c_str());
 
+    // the periodic measurement is stopped, the settings are written without restarts
     if (tSensorAltitude != uint16_t(altoffset)) {
-        setSCD4xAltitudeOffset(altoffset);
+        Serial.println("-->[SLIB] SCD4x new altitude offset\t: " + String(altoffset));
+        scd->setSensorAltitude(uint16_t(altoffset));
         delay(1);
     }
 
     offsetDifference = abs((toffset*100) - (tTemperatureOffset*100)); 
     if(offsetDifference > 0.5) { // Accounts for SCD4x conversion rounding errors in temperature offset
         Serial.println("-->[SLIB] SCD4x setting new temp offset\t: " + String(toffset));
-        setSCD4xTempOffset(toffset);
+        scd->setTemperatureOffset(toffset);
         delay(1);
     }
 
-    error = scd4x.startPeriodicMeasurement();
+    instance.variant = scd4xVariant(instance);
+    DEBUG("-->[SLIB] SCD4x sensor variant\t: ", String(instance.variant).c_str());
+    error = scd4xMeasurementStart(instance);
     if (error) {
         DEBUG("[E][SLIB] SCD4x Error Starting Periodic Measurement\t: ", String(error).c_str());
         errorToString(error, errorMessage, 256);
         DEBUG("[E][SLIB] SCD4x error msg\t:", errorMessage);
-        return;
+        return false;
     } 
-    CO2scd4xRead();
+    CO2scd4xRead(instance);
+    return true;
 }
 
 /// set SCD4x temperature compensation
 void Sensors::setSCD4xTempOffset(float offset) {
-    if (getMainDeviceSelected().equals("SCD4x")) {
+    if (main_driver == DRIVER_SCD4X) {
         Serial.println("-->[SLIB] SCD4x new temperature offset\t: " + String(offset));
         scd4x.stopPeriodicMeasurement();
         delay(510);    
         scd4x.setTemperatureOffset(offset);
-        scd4x.startPeriodicMeasurement();
+        scd4xMeasurementStart(sources[DRIVER_SCD4X]);
     }
 }
 
 /// set SCD4x altitude compensation
 void Sensors::setSCD4xAltitudeOffset(float offset) {
-    if (getMainDeviceSelected().equals("SCD4x")) {
+    if (main_driver == DRIVER_SCD4X) {
         Serial.println("-->[SLIB] SCD4x new altitude offset\t: " + String(offset));
         scd4x.stopPeriodicMeasurement();
         delay(510);    
         scd4x.setSensorAltitude(uint16_t(offset));
-        scd4x.startPeriodicMeasurement();
+        scd4xMeasurementStart(sources[DRIVER_SCD4X]);
     }
 }
 
-void Sensors::PMGCJA5Init() {
-    if (dev_uart_type == Panasonic) return;
+bool Sensors::PMGCJA5Init() {
+    if (uart_detected && dev_uart_type == Panasonic) return false;
     DEBUG("-->[SLIB] GCJA5 starting PANASONIC GCJA5 sensor..");
-    if (!pmGCJA5.begin()) return;
-    Serial.println("-->[SLIB] I2C sensor detected\t: SN-GCJA5");
-    device_selected = "PANASONIC_I2C";
-    dev_uart_type = Auto;  // TODO: it isn't a uart, but it's a uart-like device
+    if (!pmGCJA5.begin()) return false;
+    if (!uart_detected) dev_uart_type = Auto;  // TODO: it isn't a uart, but it's a uart-like device
     uint8_t status = pmGCJA5.getStatusFan();
     DEBUG("-->[SLIB] GCJA5 FAN status\t: ", String(status).c_str());
+    return true;
 }
 
-void Sensors::dhtInit() {
+bool Sensors::dhtInit() {
+    return true;  // DHT sensors can't be probed
 }
 
 // Altitude compensation for CO2 sensors without Pressure atm or Altitude compensation
 
-void Sensors::CO2correctionAlt() {
-    DEBUG("-->[SLIB] CO2 altitud original\t: ", String(CO2Val).c_str());
-    float CO2cor = (0.016 * ((1013.25 - hpa) /10 ) * (CO2Val - 400)) + CO2Val;       // Increment of 1.6% for every hpa of difference at sea level
-    CO2Val = round (CO2cor);
-    DEBUG("-->[SLIB] CO2 compensated\t: ", String(CO2Val).c_str());
+bool Sensors::isCO2Compensated() {
+    return altoffset != 0 || (co2_live_pressure && pres_smoothed > 0);
+}
+
+/**
+ * CO2 post-processing pipeline. Altitude or live pressure compensation for
+ * CO2 sensors without pressure compensation (MH-Z19, CM1106 and S8).
+ */
+void Sensors::CO2Process(uint16_t co2, bool compensate) {
+    bool compensated = compensate && isCO2Compensated();
+    svalue_t pressure = co2_live_pressure && pres_smoothed > 0 ? pres_smoothed : toSValue(hpa);
+    unitPipeline<CO2>().stage<CO2PressureStage>().pressure = compensated ? pressure : 0;
+    if (compensated) DEBUG("-->[SLIB] CO2 altitud original\t: ", String(co2).c_str());
+    unitPublish<CO2>(co2);
+    if (compensated) DEBUG("-->[SLIB] CO2 compensated\t: ", String(CO2Val).c_str());
+}
+
+/// smoothed pressure (EWMA) for the live CO2 compensation
+void Sensors::pressureUpdate(svalue_t hpa) {
+    if (hpa < 300 * SVALUE_SCALE || hpa > 1200 * SVALUE_SCALE) return;  // out of range for the atmosphere
+    if (pres_smoothed == 0)
+        pres_smoothed = hpa;
+    else
+        pres_smoothed += (saccum_t)(hpa - pres_smoothed) * PRESSURE_EWMA_ALPHA / 100;
+}
+
+/**
+ * Ambient pressure update for SCD30 and SCD4x. It is sent without stop the
+ * periodic measurement, only each CO2_PRESSURE_PUSH_INTERVAL and when the
+ * pressure changed more than CO2_PRESSURE_PUSH_DELTA.
+ */
+void Sensors::CO2PressurePush() {
+    if (!co2_live_pressure || pres_smoothed == 0) return;
+    if (pres_pushed != 0 && millis() - pres_push_time < CO2_PRESSURE_PUSH_INTERVAL) return;
+    if (abs(pres_smoothed - pres_pushed) < CO2_PRESSURE_PUSH_DELTA * SVALUE_SCALE) return;
+    uint16_t ambient = toU16(pres_smoothed);
+    if (main_driver == DRIVER_SCD30) scd30.setAmbientPressure(ambient);
+    if (main_driver == DRIVER_SCD4X) scd4x.setAmbientPressure(ambient);
+    pres_pushed = pres_smoothed;
+    pres_push_time = millis();
+    DEBUG("-->[SLIB] CO2 ambient pressure updated\t: ", String(ambient).c_str());
+}
+
+CalibrationStage *Sensors::getCalibrationStage(UNIT unit) {
+    switch (unit) {
+        case PM1:
+            return &unitPipeline<PM1>().stage<CalibrationStage>();
+        case PM25:
+            return &unitPipeline<PM25>().stage<CalibrationStage>();
+        case PM4:
+            return &unitPipeline<PM4>().stage<CalibrationStage>();
+        case PM10:
+            return &unitPipeline<PM10>().stage<CalibrationStage>();
+        case CO2:
+            return &unitPipeline<CO2>().stage<CalibrationStage>();
+        case TEMP:
+            return &unitPipeline<TEMP>().stage<CalibrationStage>();
+        case HUM:
+            return &unitPipeline<HUM>().stage<CalibrationStage>();
+        default:
+            return nullptr;
+    }
+}
+
+HampelStage *Sensors::getHampelStage(UNIT unit) {
+    switch (unit) {
+        case PM1:
+            return &unitPipeline<PM1>().stage<HampelStage>();
+        case PM25:
+            return &unitPipeline<PM25>().stage<HampelStage>();
+        case PM4:
+            return &unitPipeline<PM4>().stage<HampelStage>();
+        case PM10:
+            return &unitPipeline<PM10>().stage<HampelStage>();
+        case CO2:
+            return &unitPipeline<CO2>().stage<HampelStage>();
+        default:
+            return nullptr;
+    }
+}
+
+/// driver settings of the measurement profile
+void Sensors::profileApply(SensorInstance &instance) {
+    Adafruit_BME280 *bme = instance.device.bme280;
+    switch (instance.driver) {
+        case DRIVER_BME280:
+            if (measure_profile == PROFILE_LOW_POWER)
+                bme->setSampling(Adafruit_BME280::MODE_FORCED, Adafruit_BME280::SAMPLING_X1, Adafruit_BME280::SAMPLING_X1,
+                                   Adafruit_BME280::SAMPLING_X1, Adafruit_BME280::FILTER_OFF);
+            else if (measure_profile == PROFILE_LOW_LATENCY)
+                bme->setSampling(Adafruit_BME280::MODE_NORMAL, Adafruit_BME280::SAMPLING_X1, Adafruit_BME280::SAMPLING_X1,
+                                   Adafruit_BME280::SAMPLING_X1, Adafruit_BME280::FILTER_OFF, Adafruit_BME280::STANDBY_MS_0_5);
+            else if (measure_profile == PROFILE_HIGH_PRECISION)
+                bme->setSampling(Adafruit_BME280::MODE_NORMAL, Adafruit_BME280::SAMPLING_X2, Adafruit_BME280::SAMPLING_X16,
+                                   Adafruit_BME280::SAMPLING_X1, Adafruit_BME280::FILTER_X16, Adafruit_BME280::STANDBY_MS_500);
+            else
+                bme->setSampling();  // library defaults
+            break;
+        case DRIVER_BMP280:
+            if (measure_profile == PROFILE_LOW_POWER)
+                bmp280.setSampling(Adafruit_BMP280::MODE_FORCED, Adafruit_BMP280::SAMPLING_X1, Adafruit_BMP280::SAMPLING_X1,
+                                   Adafruit_BMP280::FILTER_OFF);
+            else if (measure_profile == PROFILE_LOW_LATENCY)
+                bmp280.setSampling(Adafruit_BMP280::MODE_NORMAL, Adafruit_BMP280::SAMPLING_X1, Adafruit_BMP280::SAMPLING_X4,
+                                   Adafruit_BMP280::FILTER_OFF, Adafruit_BMP280::STANDBY_MS_1);
+            else  // default settings from datasheet, high resolution
+                bmp280.setSampling(Adafruit_BMP280::MODE_NORMAL, Adafruit_BMP280::SAMPLING_X2, Adafruit_BMP280::SAMPLING_X16,
+                                   Adafruit_BMP280::FILTER_X16, Adafruit_BMP280::STANDBY_MS_500);
+            break;
+        case DRIVER_BME680:
+            if (measure_profile == PROFILE_LOW_POWER || measure_profile == PROFILE_LOW_LATENCY) {
+                bme680.setTemperatureOversampling(BME680_OS_1X);
+                bme680.setHumidityOversampling(BME680_OS_1X);
+                bme680.setPressureOversampling(BME680_OS_1X);
+                bme680.setIIRFilterSize(BME680_FILTER_SIZE_0);
+            } else if (measure_profile == PROFILE_HIGH_PRECISION) {
+                bme680.setTemperatureOversampling(BME680_OS_16X);
+                bme680.setHumidityOversampling(BME680_OS_16X);
+                bme680.setPressureOversampling(BME680_OS_16X);
+                bme680.setIIRFilterSize(BME680_FILTER_SIZE_7);
+            } else {
+                bme680.setTemperatureOversampling(BME680_OS_8X);
+                bme680.setHumidityOversampling(BME680_OS_2X);
+                bme680.setPressureOversampling(BME680_OS_4X);
+                bme680.setIIRFilterSize(BME680_FILTER_SIZE_3);
+            }
+            if (measure_profile == PROFILE_LOW_POWER)
+                bme680.setGasHeater(0, 0);  // gas heater off
+            else if (measure_profile == PROFILE_LOW_LATENCY)
+                bme680.setGasHeater(320, 100);
+            else
+                bme680.setGasHeater(320, 150);  // 320*C for 150 ms
+            break;
+        case DRIVER_SCD4X:
+            if (instance.mode == scd4xProfileMode(instance)) break;  // without a restart
+            instance.device.scd4x->stopPeriodicMeasurement();
+            delay(510);
+            scd4xMeasurementStart(instance);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * SCD4x measurement start on the mode of the profile. The single shot
+ * command is sent without the blocking wait of the library, its data-ready
+ * status is polled on the read.
+ */
+uint16_t Sensors::scd4xMeasurementStart(SensorInstance &instance) {
+    uint8_t mode = scd4xProfileMode(instance);
+    uint16_t error;
+    if (mode == SCD4X_MODE_SINGLE_SHOT)
+        error = scd4xCommand(instance, 0x219D);  // measure_single_shot
+    else if (mode == SCD4X_MODE_LOW_POWER)
+        error = instance.device.scd4x->startLowPowerPeriodicMeasurement();
+    else
+        error = instance.device.scd4x->startPeriodicMeasurement();
+    instance.mode = error ? SCD4X_MODE_IDLE : mode;
+    return error;
+}
+
+/// SCD4x mode of the measurement profile, the single shot is only on SCD41 and SCD43
+uint8_t Sensors::scd4xProfileMode(SensorInstance &instance) {
+    if (measure_profile != PROFILE_LOW_POWER) return SCD4X_MODE_PERIODIC;
+    if (instance.variant == SCD4X_VARIANT_SCD41 || instance.variant == SCD4X_VARIANT_SCD43) return SCD4X_MODE_SINGLE_SHOT;
+    return SCD4X_MODE_LOW_POWER;
+}
+
+/// SCD4x variant (get_sensor_variant, idle mode), SCD40 on firmwares without it
+uint8_t Sensors::scd4xVariant(SensorInstance &instance) {
+    uint8_t buffer[3];
+    SensirionI2CTxFrame txFrame(buffer, 2);
+    txFrame.addCommand(0x202F);
+    if (SensirionI2CCommunication::sendFrame(instance.address, txFrame, *instance.bus)) return SCD4X_VARIANT_SCD40;
+    delay(1);
+    SensirionI2CRxFrame rxFrame(buffer, 3);
+    uint16_t variant = 0;
+    if (SensirionI2CCommunication::receiveFrame(instance.address, 3, rxFrame, *instance.bus)) return SCD4X_VARIANT_SCD40;
+    if (rxFrame.getUInt16(variant)) return SCD4X_VARIANT_SCD40;
+    return variant >> 12;
+}
+
+/// one SCD4x command without arguments and without the wait of the library
+uint16_t Sensors::scd4xCommand(SensorInstance &instance, uint16_t command) {
+    uint8_t buffer[2];
+    SensirionI2CTxFrame txFrame(buffer, 2);
+    txFrame.addCommand(command);
+    return SensirionI2CCommunication::sendFrame(instance.address, txFrame, *instance.bus);
 }
 
 float Sensors::hpaCalculation(float altitude) {
@@ -1257,94 +2535,785 @@ float Sensors::hpaCalculation(float altitude) {
 void Sensors::printValues() {
     if (!devmode) return;
     char output[256];
-    sprintf(output, "PM1:%03d PM25:%03d PM10:%03d CO2:%04d CO2humi:%03f%% CO2temp:%03f°C H:%03f%% T:%03f°C", pm1, pm25, pm10, CO2Val, CO2humi, CO2temp, humi, temp);
+    sprintf(output, "PM1:%03d PM25:%03d PM10:%03d CO2:%04d CO2humi:%03f%% CO2temp:%03f°C H:%03f%% T:%03f°C", pm1, pm25, pm10, CO2Val, fromSValue(CO2humi), fromSValue(CO2temp), fromSValue(humi), fromSValue(temp));
     DEBUG("-->[SLIB]", output);
 }
 
 bool Sensors::isUnitRegistered(UNIT unit) {
-    for (int i = 0; i < MAX_UNITS_SUPPORTED; i++) {
-        if (units_registered[i] == unit) return true;
-    }
-    return false;
+    return units_registered_mask.test(unit);
 }
 
 void Sensors::unitRegister(UNIT unit) {
+    if (current_source < SOURCES_MAX) driver_units[current_source].set(unit);
+    unit_timestamp[unit] = millis();
     if (isUnitRegistered(unit)) return;
     units_registered[units_registered_count++] = unit;
+    units_registered_mask.set(unit);
 }
 
 void Sensors::resetUnitsRegister() {
     units_registered_count = 0;
+    units_registered_mask.clear();
     for (int i = 0; i < MAX_UNITS_SUPPORTED; i++) {
         units_registered[i] = 0;
     }
 }
 
-uint8_t * Sensors::getUnitsRegistered() {
+uint16_t * Sensors::getUnitsRegistered() {
     return units_registered;
 }
 
-uint8_t Sensors::getUnitsRegisteredCount() {
+uint16_t Sensors::getUnitsRegisteredCount() {
     return units_registered_count;
 }
 
+/// descriptor of a built-in or runtime unit, nullptr if it is not registered
+const Sensors::UnitDescriptor *Sensors::unitDescriptor(UNIT unit) {
+    if (unit < UNITS_BUILTIN) return &unit_descriptors[unit];
+    if (unit < UNITS_BUILTIN + units_dynamic_count) return &unit_dynamic_descriptors[unit - UNITS_BUILTIN];
+    return nullptr;
+}
+
 String Sensors::getUnitName(UNIT unit) {
-    return String(unit_name[unit]);
+    return String(unitName(unit));
 }
 
 String Sensors::getUnitSymbol(UNIT unit) {
-    return String(unit_symbol[unit]);
+    const UnitDescriptor *descriptor = unitDescriptor(unit);
+    return descriptor != nullptr ? String(descriptor->symbol) : "";
 }
 
-int Sensors::getNextUnit() {
-    for (int i = current_unit; i < MAX_UNITS_SUPPORTED; i++) {
-        if (units_registered[i] != 0) {
-            current_unit = i + 1;
-            return units_registered[i];
-        }
+const char *Sensors::unitName(UNIT unit) {
+    const UnitDescriptor *descriptor = unitDescriptor(unit);
+    return descriptor != nullptr ? descriptor->name : "";
+}
+
+/// resolution of the unit values: 1 integer units, UNIT_VALUE_SCALE hundredths (0 if not registered)
+uint16_t Sensors::getUnitScale(UNIT unit) {
+    const UnitDescriptor *descriptor = unitDescriptor(unit);
+    return descriptor != nullptr ? descriptor->scale : 0;
+}
+
+/**
+ * New unit at runtime (i.e. VOC index, AQI or values of external sensors),
+ * without editing SENSOR_UNITS. Its values are set with setUnitValue() and
+ * they are published on the next sample round like the built-in units.
+ * @param scale resolution of the values, 1 for integer units
+ * @return the new unit, NUNIT if the registry is full (SENSORLIB_MAX_UNITS)
+ */
+UNIT Sensors::registerUnit(const char *symbol, const char *name, uint16_t scale) {
+    if (UNITS_BUILTIN + units_dynamic_count >= MAX_UNITS_SUPPORTED || scale == 0) return NUNIT;
+    UNIT unit = (UNIT)(UNITS_BUILTIN + units_dynamic_count);
+    unit_dynamic_descriptors[units_dynamic_count++] = {unit, symbol, name, scale, unitSlot(nullptr)};
+    return unit;
+}
+
+/**
+ * New value of a unit, built-in or registered at runtime. On a driver read
+ * (external drivers) it is a sensor reading: it is post-processed with the
+ * pipeline of the unit, temperature and humidity are sources of the fusion,
+ * and it is published on this round. Else it is published on the next round.
+ */
+bool Sensors::setUnitValue(UNIT unit, float value) {
+    const UnitDescriptor *descriptor = unitDescriptor(unit);
+    if (unit == NUNIT || descriptor == nullptr) return false;
+    if (current_source < DRIVERS_MAX) value = fromSValue(unitProcess(unit, toSValue(value)));
+    unitStore(unit, toSValue(roundf(value * descriptor->scale) / descriptor->scale));  // resolution of the unit
+    if (current_source < DRIVERS_MAX) {
+        unitRegister(unit);
+        return true;
+    }
+    unit_timestamp[unit] = millis();
+    units_value_set.set(unit);
+    return true;
+}
+
+/// value of one unit on its storage, temperature and humidity are sources of the fusion
+void Sensors::unitStore(UNIT unit, svalue_t value) {
+    if (unit == TEMP)
+        setSourceTemperature(value);
+    else if (unit == HUM)
+        setSourceHumidity(value);
+    else if (unit >= UNITS_BUILTIN)
+        unit_dynamic[unit - UNITS_BUILTIN] = value;
+    else if (unit_descriptors[unit].slot.u16 != nullptr)
+        this->*unit_descriptors[unit].slot.u16 = toU16(value);
+    else if (unit_descriptors[unit].slot.value != nullptr)
+        this->*unit_descriptors[unit].slot.value = value;
+}
+
+/// built-in and runtime units
+uint16_t Sensors::getUnitsCount() {
+    return UNITS_BUILTIN + units_dynamic_count;
+}
+
+/// units set out of a driver read are registered on the sample round
+void Sensors::unitsValueRegister() {
+    for (int i = 1; i < MAX_UNITS_SUPPORTED; i++) {
+        if (!units_value_set.test((UNIT)i)) continue;
+        uint32_t timestamp = unit_timestamp[i];
+        unitRegister((UNIT)i);
+        unit_timestamp[i] = timestamp;  // time of the value, not of the round
+        dataReady = true;
     }
+    units_value_set.clear();
+}
+
+int Sensors::getNextUnit() {
+    if (current_unit < units_registered_count) return units_registered[current_unit++];
     current_unit = 0;
     return 0;
 }
 
 uint32_t Sensors::getUnitValue(UNIT unit) {
-    switch (unit) {
-        case PM1:
-            return pm1;
-        case PM25:
-            return pm25;
-        case PM10:
-            return pm10;
-        case PM4:
-            return pm4;
-        case CO2:
-            return CO2Val;
-        case CO2HUM:
-            return (uint32_t) CO2humi;
-        case CO2TEMP:
-            return (uint32_t) CO2temp;
-        case HUM:
-            return (uint32_t) humi;
-        case TEMP:
-            return (uint32_t) temp;
-        case PRESS:
-            return (uint32_t) hpa;
-        case ALT:
-            return (uint32_t) alt;
-        case GAS:
-            return (uint32_t) gas;
+    if (unit < UNITS_BUILTIN && unit_descriptors[unit].slot.u16 != nullptr) return this->*unit_descriptors[unit].slot.u16;
+    return (uint32_t)(getUnitSValue(unit) / SVALUE_SCALE);
+}
+
+/**
+ * Unit value without truncation, in hundredths (UNIT_VALUE_SCALE). It keeps
+ * decimals and negative values, i.e. -3.25 °C is -325.
+ */
+int32_t Sensors::getUnitValueScaled(UNIT unit) {
+    return toUnitScaled(getUnitSValue(unit));
+}
+
+float Sensors::getUnitFloatValue(UNIT unit) {
+    return fromSValue(getUnitSValue(unit));
+}
+
+/**
+ * Bulk export of all units registered on the last sample round, in one pass
+ * and without the getNextUnit() cursor. Values are in hundredths
+ * (UNIT_VALUE_SCALE) with the timestamp of its sensor read. It copies a
+ * snapshot under lock, then it is safe to call it from other task.
+ * @param values caller array
+ * @param size max units to copy (MAX_UNITS_SUPPORTED for all)
+ * @return units copied
+ */
+uint16_t Sensors::getUnitsValues(UnitValue *values, uint16_t size) {
+    SNAPSHOT_LOCK();
+    uint16_t count = min(size, units_snapshot_count);
+    memcpy(values, units_snapshot, count * sizeof(UnitValue));
+    SNAPSHOT_UNLOCK();
+    return count;
+}
+
+/// millis() of the last measurement of the unit (sensor read with new data)
+uint32_t Sensors::getUnitTimestamp(UNIT unit) {
+    if (unit >= MAX_UNITS_SUPPORTED) return 0;
+    return unit_timestamp[unit];
+}
+
+/// snapshot of the units values at the end of the sample round, written in place (without a stack copy)
+void Sensors::unitsSnapshot() {
+    SNAPSHOT_LOCK();
+    for (int i = 0; i < units_registered_count; i++) {
+        UNIT unit = (UNIT)units_registered[i];
+        units_snapshot[i] = {unit, getUnitValueScaled(unit), unit_timestamp[unit]};
+    }
+    units_snapshot_count = units_registered_count;
+    SNAPSHOT_UNLOCK();
+}
+
+/// value of one unit from its storage slot, O(1) on the registry
+svalue_t Sensors::getUnitSValue(UNIT unit) {
+    if (unit >= UNITS_BUILTIN) return unit < UNITS_BUILTIN + units_dynamic_count ? unit_dynamic[unit - UNITS_BUILTIN] : 0;
+    const UnitSlot &slot = unit_descriptors[unit].slot;
+    if (slot.u16 != nullptr) return toSValue(this->*slot.u16);
+    if (slot.value != nullptr) return this->*slot.value;
+    return 0;
+}
+
+bool Sensors::isUnitChanged(UNIT unit) {
+    if (!units_reported.test(unit)) return true;
+    svalue_t last = unit_last_reported[unit];
+    svalue_t delta = abs(getUnitSValue(unit) - last);
+    if (unit_deadband_abs[unit] == 0 && unit_deadband_rel[unit] == 0) return delta > 0;
+    if (unit_deadband_abs[unit] > 0 && delta >= unit_deadband_abs[unit]) return true;
+    if (unit_deadband_rel[unit] > 0 && (saccum_t)delta * 1000 >= (saccum_t)unit_deadband_rel[unit] * abs(last)) return true;
+    return false;
+}
+
+/**
+ * Change-driven reporting. Only the units moved beyond its deadband
+ * update the last reported value, then slow drifts are reported too.
+ */
+void Sensors::checkChangedUnits() {
+    changed_units.clear();
+    for (int i = 0; i < units_registered_count; i++) {
+        UNIT unit = (UNIT)units_registered[i];
+        if (isUnitChanged(unit)) changed_units.set(unit);
+    }
+    bool heartbeat = max_silence > 0 && (millis() - last_report_time > max_silence);
+    if (!changed_units.any() && !heartbeat) return;
+    for (int i = 0; i < units_registered_count; i++) {
+        UNIT unit = (UNIT)units_registered[i];
+        if (!heartbeat && !changed_units.test(unit)) continue;
+        unit_last_reported[unit] = getUnitSValue(unit);
+        units_reported.set(unit);
+    }
+    last_report_time = millis();
+    if (_onChangedCb != nullptr) _onChangedCb(changed_units);
+}
+
+/**
+ * Read one source on the sample round, the main sensor of a driver or a
+ * sensor instance (on its bus and mux channel). With adaptive sampling, the
+ * sources not due on this round keep its last values and units registered.
+ */
+void Sensors::sourceRead(uint8_t source) {
+    if (!isSourceDetected(source)) return;
+    if (!isDriverDue(source)) {
+        driverUnitsRestore(source);
+        return;
+    }
+    if (!isDriverRetryDue(source)) return;
+    if (!i2cBusAvailable(source)) {
+        i2c_bus_deferred |= (1UL << source);
+        if (driver_units[source].any()) driverUnitsRestore(source);
+        return;
+    }
+    const DriverOps *ops = sourceOps(source);
+    SensorInstance &instance = sources[source];
+    uint32_t start = micros();
+    if (ops->address != 0) i2cMuxSelect(instance.mux, instance.channel);  // main sensors close the mux channels
+    current_source = source;
+    if (driver_health[source].backoff > 0 && source != DRIVER_UART) {
+        DEBUG("-->[SLIB] driver init retry\t: ", ops->name);
+        if (source < DRIVERS_MAX)
+            driverInit((SENSOR_DRIVER)source);
+        else
+            ops->init(*this, instance);
+    }
+    driver_units_prev = driver_units[source];
+    driver_units_kept = false;
+    driver_units[source].clear();
+    ops->collect(*this, instance);
+    drivers_started &= ~(1UL << source);
+    driver_last_read[source] = millis();
+    if (ops->address != 0) i2cBusTimeUpdate(source, micros() - start);
+    if (adaptive_sampling && driver_units[source].any() && !driver_units_kept) adaptiveUpdate(source);
+    if (!driver_units_kept) driverHealthUpdate(source, driver_units[source].any());  // pending measurements are not failures
+    current_source = SOURCES_MAX;
+}
+
+/**
+ * UART sensor read (main UART, its detection is on init). With adaptive
+ * sampling on long periods the SDS011 sleeps between reads, and it is woken
+ * up SDS011_WARMUP before the read by its start (driver lead time).
+ */
+void Sensors::uartDriverRead() {
+    if (i2conly) return;
+    if (sds011_sleeping) {
+        sds011SetWorkMode(true);  // loop() was not called on the lead time, it is read after its warm up
+        driverUnitsKeep();
+        return;
+    }
+    dataReady = pmSensorRead();
+    DEBUG("-->[SLIB] UART data ready\t: ",String(dataReady).c_str());
+    if (dev_uart_type == SDS011 && adaptive_sampling && driver_interval[DRIVER_UART] >= SDS011_WARMUP * 2UL)
+        sds011SetWorkMode(false);
+}
+
+bool Sensors::uartDriverInit() {
+    return uart_detected;
+}
+
+/// SDS011 fan wake up, SDS011_WARMUP before its read
+bool Sensors::uartDriverStart() {
+    if (sds011_sleeping) sds011SetWorkMode(true);
+    return true;
+}
+
+void Sensors::sps30DriverRead() {
+    sps30Read();
+}
+
+/// start of the drivers without a measurement start
+bool Sensors::driverNoStart() {
+    return true;
+}
+
+const DriverOps *Sensors::driverOps(SENSOR_DRIVER driver) {
+    if (driver < DRIVER_COUNT) return &builtin_drivers[driver];
+    if (driver < DRIVER_COUNT + external_drivers_count) return external_drivers[driver - DRIVER_COUNT];
+    return nullptr;
+}
+
+const char *Sensors::driverName(SENSOR_DRIVER driver) {
+    const DriverOps *ops = driverOps(driver);
+    return ops != nullptr ? ops->name : "";
+}
+
+/// driver of one source: source N is SENSOR_DRIVER N, then the instances and the extra UART sensors
+const DriverOps *Sensors::sourceOps(uint8_t source) {
+    if (source < DRIVERS_MAX) return driverOps((SENSOR_DRIVER)source);
+    if (source < DRIVERS_MAX + instances_count) return driverOps(sources[source].driver);
+    if (source >= UART_SOURCES_FIRST && source < UART_SOURCES_FIRST + uart_slots_count) return &uart_slot_driver;
+    return nullptr;
+}
+
+/// context of the main sensors, on the main bus with the driver objects of the library
+void Sensors::sourcesInit() {
+    for (int i = 0; i < DRIVERS_MAX; i++) {
+        SensorInstance &instance = sources[i];
+        const DriverOps *ops = driverOps((SENSOR_DRIVER)i);
+        instance = SensorInstance();
+        instance.driver = (SENSOR_DRIVER)i;
+        instance.bus = &Wire;
+        instance.mux = -1;
+        instance.channel = -1;
+        instance.address = ops != nullptr ? ops->address : 0;
+        instance.units_first = NUNIT;
+    }
+    sources[DRIVER_SHT31].device.sht31 = &sht31;
+    sources[DRIVER_BME280].device.bme280 = &bme280;
+    sources[DRIVER_SCD30].device.scd30 = &scd30;
+    sources[DRIVER_SCD4X].device.scd4x = &scd4x;
+}
+
+/// measurement start of the sources due on this round without lead time, before all reads
+void Sensors::driverStart(uint8_t source) {
+    const DriverOps *ops = sourceOps(source);
+    if (ops == nullptr || ops->start == nullptr || ops->lead > 0 || !isSourceDetected(source)) return;
+    if (!isDriverDue(source) || !isDriverRetryDue(source)) return;
+    if (ops->address != 0) i2cMuxSelect(sources[source].mux, sources[source].channel);
+    ops->start(*this, sources[source]);
+}
+
+/**
+ * Measurement start of the drivers with a lead time, on each loop(). They
+ * are started (or polled until they are started) on its lead time before
+ * the sample round, and they are collected on the round.
+ * @param next_round time to the next sample round (ms)
+ */
+void Sensors::driversSchedule(uint32_t next_round) {
+    for (int i = 0; i < SOURCES_MAX; i++) {
+        const DriverOps *ops = sourceOps(i);
+        if (ops == nullptr || ops->start == nullptr || ops->lead == 0 || next_round > ops->lead) continue;
+        if (drivers_started & (1UL << i)) continue;  // started, it is collected on the round
+        if (!isSourceDetected(i) || driverDueTime(i) > ops->lead || !isDriverRetryDue(i)) continue;
+        if (ops->address != 0) i2cMuxSelect(sources[i].mux, sources[i].channel);
+        if (ops->start(*this, sources[i])) drivers_started |= (1UL << i);
+    }
+    i2cMuxRelease();
+}
+
+/// drivers found on init, only they are read
+bool Sensors::isDriverDetected(SENSOR_DRIVER driver) {
+    if (driver == DRIVER_UART) return !i2conly && uart_detected && _serial != nullptr;
+    return drivers_detected & (1UL << driver);
+}
+
+/// main sensors detected on init, sensor instances and extra UART sensors
+bool Sensors::isSourceDetected(uint8_t source) {
+    if (source < DRIVERS_MAX) return isDriverDetected((SENSOR_DRIVER)source);
+    if (source >= UART_SOURCES_FIRST) return !i2conly && source < UART_SOURCES_FIRST + uart_slots_count;
+    return source < DRIVERS_MAX + instances_count;
+}
+
+bool Sensors::isI2CDriver(SENSOR_DRIVER driver) {
+    return driverOps(driver) != nullptr && driverOps(driver)->address != 0;
+}
+
+/// the source read fits on the I2C bus budget of this round
+bool Sensors::i2cBusAvailable(uint8_t source) {
+    if (i2c_bus_budget == 0 || sourceOps(source)->address == 0 || i2c_bus_used == 0) return true;
+    return i2c_bus_used + driver_bus_time[source] <= i2c_bus_budget;
+}
+
+void Sensors::i2cBusTimeUpdate(uint8_t source, uint32_t elapsed) {
+    uint32_t *time = &driver_bus_time[source];
+    *time = *time == 0 ? elapsed : (*time * (100 - I2C_BUS_TIME_ALPHA) + elapsed * I2C_BUS_TIME_ALPHA) / 100;
+    i2c_bus_used += elapsed;
+}
+
+/// the fastest clock that all I2C drivers detected support, on each bus
+void Sensors::i2cClockApply() {
+    uint32_t khz = 0;
+    for (int i = 0; i < DRIVERS_MAX; i++) {
+        SENSOR_DRIVER driver = (SENSOR_DRIVER)i;
+        if (!isI2CDriver(driver) || !(drivers_detected & (1UL << i)) || i2c_clock[i] == 0) continue;
+        if (khz == 0 || i2c_clock[i] < khz) khz = i2c_clock[i];
+    }
+    for (int i = DRIVERS_MAX; i < DRIVERS_MAX + instances_count; i++) {
+        uint16_t clock = i2c_clock[sources[i].driver];
+        if (sources[i].bus == &Wire && (khz == 0 || clock < khz)) khz = clock;
+    }
+    if (khz != 0 && khz != i2c_clock_applied) {
+        i2c_clock_applied = khz;
+        Wire.setClock(khz * 1000UL);
+        Serial.println("-->[SLIB] I2C bus clock\t\t: " + String(khz) + "kHz");
+    }
+    for (int b = 0; b < i2c_buses_count; b++) {
+        uint32_t bus_khz = 0;
+        for (int i = DRIVERS_MAX; i < DRIVERS_MAX + instances_count; i++) {
+            uint16_t clock = i2c_clock[sources[i].driver];
+            if (sources[i].bus == i2c_buses[b] && (bus_khz == 0 || clock < bus_khz)) bus_khz = clock;
+        }
+        if (bus_khz != 0) i2c_buses[b]->setClock(bus_khz * 1000UL);
+    }
+}
+
+/// open one mux channel, only when it is not the current one
+void Sensors::i2cMuxSelect(int8_t mux, int8_t channel) {
+    if (mux == mux_selected && channel == mux_channel_selected) return;
+    if (mux_selected >= 0 && mux != mux_selected) i2cMuxRelease();
+    if (mux < 0) return;
+    TwoWire *bus = i2c_muxes[mux].bus;
+    bus->beginTransmission(i2c_muxes[mux].address);
+    bus->write((uint8_t)(1 << channel));
+    bus->endTransmission();
+    mux_selected = mux;
+    mux_channel_selected = channel;
+}
+
+/// close the channels of the current mux, sensors behind it are hidden to the main drivers
+void Sensors::i2cMuxRelease() {
+    if (mux_selected < 0) return;
+    TwoWire *bus = i2c_muxes[mux_selected].bus;
+    bus->beginTransmission(i2c_muxes[mux_selected].address);
+    bus->write((uint8_t)0);
+    bus->endTransmission();
+    mux_selected = -1;
+    mux_channel_selected = -1;
+}
+
+bool Sensors::i2cProbe(TwoWire *bus, uint8_t address) {
+    bus->beginTransmission(address);
+    return bus->endTransmission() == 0;
+}
+
+/**
+ * Sensors instances detection on the extra buses and mux channels, in
+ * bus, mux and channel order, then the reads switch each channel once.
+ * They are sources like the main sensors (see sourceRead).
+ */
+void Sensors::instancesInit() {
+    for (int b = 0; b < i2c_buses_count; b++) instancesDetect(i2c_buses[b], -1, -1);
+    for (int m = 0; m < i2c_muxes_count; m++) {
+        for (int c = 0; c < I2C_MUX_CHANNELS; c++) instancesDetect(i2c_muxes[m].bus, m, c);
+    }
+    i2cMuxRelease();
+    if (instances_count > 0) Serial.println("-->[SLIB] I2C sensor instances\t: " + String(instances_count));
+}
+
+void Sensors::instancesDetect(TwoWire *bus, int8_t mux, int8_t channel) {
+    static const SENSOR_DRIVER drivers[] = {DRIVER_SHT31, DRIVER_SHT31, DRIVER_BME280, DRIVER_BME280, DRIVER_SCD30, DRIVER_SCD4X};
+    static const uint8_t addresses[] = {0x44, 0x45, 0x76, 0x77, 0x61, 0x62};
+    uint8_t upstream = 0;  // devices of the bus (without mux channels) are not instances
+    if (mux >= 0) {
+        i2cMuxRelease();
+        for (int i = 0; i < 6; i++) {
+            if (i2cProbe(bus, addresses[i])) upstream |= (1 << i);
+        }
+        i2cMuxSelect(mux, channel);
+    }
+    for (int i = 0; i < 6 && instances_count < SENSOR_INSTANCES_MAX; i++) {
+        if ((upstream & (1 << i)) || !i2cProbe(bus, addresses[i])) continue;
+        uint8_t source = DRIVERS_MAX + instances_count;
+        SensorInstance &instance = sources[source];
+        instance = SensorInstance();
+        instance.driver = drivers[i];
+        instance.bus = bus;
+        instance.mux = mux;
+        instance.channel = channel;
+        instance.address = addresses[i];
+        instance.units_first = NUNIT;
+        if (!instanceDeviceNew(instance)) continue;
+        current_source = source;  // its init reads are published to the instance
+        bool found = driverOps(instance.driver)->init(*this, instance);
+        current_source = SOURCES_MAX;
+        if (!found) {
+            instanceDeviceDelete(instance);
+            continue;
+        }
+        Serial.printf("-->[SLIB] I2C instance detected\t: %s mux %i channel %i\n", driverName(drivers[i]), mux, channel);
+        sourceUnitsRegister(DRIVERS_MAX + instances_count++);
+    }
+}
+
+/// own driver object of one instance, on its bus
+bool Sensors::instanceDeviceNew(SensorInstance &instance) {
+    switch (instance.driver) {
+        case DRIVER_SHT31:
+            instance.device.sht31 = new Adafruit_SHT31(instance.bus);
+            return true;
+        case DRIVER_BME280:
+            instance.device.bme280 = new Adafruit_BME280();
+            return true;
+        case DRIVER_SCD30:
+            instance.device.scd30 = new SCD30();
+            return true;
+        case DRIVER_SCD4X:
+            instance.device.scd4x = new SensirionI2CScd4x();
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Sensors::instanceDeviceDelete(SensorInstance &instance) {
+    switch (instance.driver) {
+        case DRIVER_SHT31:
+            delete instance.device.sht31;
+            break;
+        case DRIVER_BME280:
+            delete instance.device.bme280;
+            break;
+        case DRIVER_SCD30:
+            delete instance.device.scd30;
+            break;
+        case DRIVER_SCD4X:
+            delete instance.device.scd4x;
+            break;
         default:
-            return 0;
+            break;
     }
 }
 
+/**
+ * Runtime units of one instance or extra UART sensor, one for each unit of
+ * the source with its number on the name (i.e. "Temp.1" and "Hum.1" of the
+ * first SHT31 instance, "PM2.5.U1" of the first extra UART sensor).
+ */
+void Sensors::sourceUnitsRegister(uint8_t source) {
+    SensorInstance &context = sources[source];
+    const UNIT *units = sourceUnits(source);
+    bool uart = source >= UART_SOURCES_FIRST;
+    unsigned number = (uart ? source - UART_SOURCES_FIRST : source - DRIVERS_MAX) + 1;
+    int count = 0;
+    while (count < INSTANCE_UNITS_MAX && units[count] != NUNIT) count++;
+    if (UNITS_BUILTIN + units_dynamic_count + count > MAX_UNITS_SUPPORTED) {
+        Serial.println("[W][SLIB] units registry full, source without units\t: " + String(source));
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        const UnitDescriptor *descriptor = unitDescriptor(units[i]);
+        char *name = source_names[source - DRIVERS_MAX][i];
+        snprintf(name, INSTANCE_NAME_MAX, uart ? "%s.U%u" : "%s.%u", descriptor->name, number);
+        UNIT unit = registerUnit(descriptor->symbol, name, descriptor->scale);
+        if (i == 0) context.units_first = unit;  // the units of one source are contiguous
+    }
+}
+
+/// units of one source: the units of its driver, on extra UART sensors the units of its type
+const UNIT *Sensors::sourceUnits(uint8_t source) {
+    if (source < UART_SOURCES_FIRST) return driverOps(sources[source].driver)->units;
+    int type = sources[source].device.uart->type;
+    return type == Mhz19 || type == CM1106 || type == SENSEAIRS8 ? uart_co2_units : uart_pm_units;
+}
+
+/// unit of one source for a unit of its driver: the same on main sensors, its runtime unit on the others
+UNIT Sensors::sourceUnit(uint8_t source, UNIT unit) {
+    if (source < DRIVERS_MAX) return unit;
+    const UNIT *units = sourceUnits(source);
+    if (sources[source].units_first == NUNIT || units == nullptr) return NUNIT;
+    for (int i = 0; i < INSTANCE_UNITS_MAX && units[i] != NUNIT; i++) {
+        if (units[i] == unit) return (UNIT)(sources[source].units_first + i);
+    }
+    return NUNIT;
+}
+
+bool Sensors::isDriverRetryDue(uint8_t source) {
+    if (!driver_backoff || driver_health[source].backoff == 0) return true;
+    return (int32_t)(millis() - driver_health[source].retry_time) >= 0;
+}
+
+/**
+ * Health update after each read. The backoff level is increased on each
+ * failed read after the threshold, and cleared on the first success.
+ */
+void Sensors::driverHealthUpdate(uint8_t source, bool success) {
+    DriverHealth *health = &driver_health[source];
+    if (success) {
+        if (health->backoff > 0) Serial.println("-->[SLIB] driver recovered\t: " + String(sourceOps(source)->name));
+        health->failures = 0;
+        health->backoff = 0;
+        health->last_success = millis();
+        return;
+    }
+    if (health->failures < UINT16_MAX) health->failures++;
+    if (!driver_backoff || health->failures < HEALTH_FAIL_THRESHOLD) return;
+    health->backoff = min(health->backoff + 1, HEALTH_BACKOFF_MAX);
+    uint32_t period = adaptive_sampling ? sample_min : sample_time * (uint32_t)1000;
+    health->retry_time = millis() + (period << health->backoff);
+    if (devmode) Serial.printf("-->[SLIB] %s failing, retry in\t: %lus\n", sourceOps(source)->name, (unsigned long)((period << health->backoff) / 1000));
+}
+
+bool Sensors::isDriverDue(uint8_t source) {
+    return driverDueTime(source) == 0;
+}
+
+/**
+ * Time to the next read of a driver (ms), 0 if it is due on this round: its
+ * min period and its adaptive sampling period, both with half round of
+ * tolerance. Drivers without units yet are always due.
+ */
+uint32_t Sensors::driverDueTime(uint8_t source) {
+    if (!driver_units[source].any()) return 0;
+    uint32_t round = adaptive_sampling ? sample_min : sample_time * (uint32_t)1000;
+    uint32_t period = sourceOps(source)->period * 1000UL;
+    if (adaptive_sampling && driver_interval[source] > period) period = driver_interval[source];
+    if (period <= round / 2) return 0;
+    uint32_t elapsed = millis() - driver_last_read[source];
+    return elapsed + round / 2 >= period ? 0 : period - round / 2 - elapsed;
+}
+
+/// the current source has not a new measurement yet (it isn't a failure), then its last units are kept
+void Sensors::driverUnitsKeep() {
+    if (current_source >= SOURCES_MAX) return;
+    driver_units_kept = true;
+    if (!driver_units_prev.any()) return;
+    driver_units[current_source] = driver_units_prev;
+    driverUnitsRestore(current_source);
+}
+
+/// register again the units of the last read of a source not due on this round
+void Sensors::driverUnitsRestore(uint8_t source) {
+    for (int i = 1; i < MAX_UNITS_SUPPORTED; i++) {
+        if (!driver_units[source].test((UNIT)i) || isUnitRegistered((UNIT)i)) continue;
+        units_registered[units_registered_count++] = i;  // it keeps the timestamp of the last read
+        units_registered_mask.set((UNIT)i);
+    }
+    dataReady = true;
+}
+
+UNIT Sensors::getDriverPrimaryUnit(uint8_t source) {
+    if (source == DRIVER_UART) return getMainSensorTypeSelected() == SENSOR_CO2 ? CO2 : PM25;
+    if (source >= UART_SOURCES_FIRST) return sourceUnit(source, sourceUnits(source)[0]);
+    const DriverOps *ops = sourceOps(source);
+    return ops != nullptr ? sourceUnit(source, ops->unit) : NUNIT;
+}
+
+/// square root of a variance, integer (bitwise) on fixed-point mode
+static svalue_t accumSqrt(saccum_t value) {
+#ifdef SENSORLIB_FIXED_POINT
+    uint64_t x = value > 0 ? value : 0, result = 0, bit = 1ULL << 62;
+    while (bit > x) bit >>= 2;
+    while (bit != 0) {
+        if (x >= result + bit) {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        } else
+            result >>= 1;
+        bit >>= 2;
+    }
+    return (svalue_t)result;
+#else
+    return sqrt(value);
+#endif
+}
+
+/**
+ * Adaptive sampling update, it uses EWMA mean and variance of the primary
+ * unit of the driver. A fast change returns to the fastest period, and
+ * a stable signal doubles the period up to the slowest one.
+ */
+void Sensors::adaptiveUpdate(uint8_t source) {
+    svalue_t x = getUnitSValue(getDriverPrimaryUnit(source));
+    if (driver_interval[source] == 0) {
+        driver_ewma[source] = x;
+        driver_ewvar[source] = 0;
+        driver_interval[source] = sample_min;
+        return;
+    }
+    svalue_t mean = driver_ewma[source];
+    svalue_t diff = x - mean;
+    svalue_t sigma = accumSqrt(driver_ewvar[source]);
+    svalue_t fast = max(max((svalue_t)(ADAPTIVE_FAST_SIGMAS * sigma), (svalue_t)(abs(mean) * ADAPTIVE_FAST_REL / 100)), (svalue_t)SVALUE_SCALE);
+    svalue_t stable = max((svalue_t)(abs(mean) * ADAPTIVE_STABLE_REL / 100), (svalue_t)(SVALUE_SCALE / 2));
+
+    if (abs(diff) > fast)
+        driver_interval[source] = sample_min;
+    else if (sigma <= stable)
+        driver_interval[source] = min(driver_interval[source] * 2, sample_max);
+
+    driver_ewma[source] = mean + (saccum_t)diff * ADAPTIVE_EWMA_ALPHA / 100;
+    driver_ewvar[source] = (100 - ADAPTIVE_EWMA_ALPHA) * (driver_ewvar[source] + (saccum_t)diff * diff * ADAPTIVE_EWMA_ALPHA / 100) / 100;
+
+    if (devmode) Serial.printf("-->[SLIB] %s sample time\t: %lus\n", sourceOps(source)->name, (unsigned long)(driver_interval[source] / 1000));
+}
+
+/**
+ * Driver detection: its probe (I2C acknowledge) and init. The drivers with
+ * a device name are the main device, the last one detected on init order.
+ */
+void Sensors::driverInit(SENSOR_DRIVER driver) {
+    const DriverOps *ops = driverOps(driver);
+    if (ops == nullptr || driver == DRIVER_UART) return;  // UART sensors are detected with its pins on init()
+    if (ops->probe != nullptr && !ops->probe(*this, sources[driver])) return;
+    if (!ops->init(*this, sources[driver])) return;
+    drivers_detected |= (1UL << driver);
+    if (ops->device != nullptr) {
+        device_selected = ops->device;
+        main_driver = driver;
+    }
+    if (ops->probe == nullptr) return;  // without probe it could be absent (DHT)
+    if (isI2CDriver(driver))
+        Serial.println("-->[SLIB] I2C sensor detected\t: " + String(ops->name));
+    else
+        Serial.println("-->[SLIB] sensor detected\t\t: " + String(ops->name));
+}
+
+uint8_t Sensors::detectionCacheChecksum(SensorsCache *cache) {
+    uint8_t checksum = 0;
+    uint8_t *data = (uint8_t *)cache;
+    for (size_t i = 0; i < offsetof(SensorsCache, checksum); i++) checksum = (checksum << 1 | checksum >> 7) ^ data[i];
+    return checksum;
+}
+
+bool Sensors::loadDetectionCache(SensorsCache *cache) {
+    bool loaded = false;
+#ifdef ARDUINO_ARCH_ESP32
+    *cache = rtc_detection_cache;
+    loaded = cache->magic == DETECTION_CACHE_MAGIC;
+    if (!loaded) {
+        Preferences preferences;
+        preferences.begin("sensorlib", true);
+        loaded = preferences.getBytes("detection", cache, sizeof(SensorsCache)) == sizeof(SensorsCache);
+        preferences.end();
+    }
+#elif defined(ARDUINO_ARCH_ESP8266)
+    loaded = ESP.rtcUserMemoryRead(SENSORLIB_RTC_OFFSET, (uint32_t *)cache, sizeof(SensorsCache));
+#endif
+    return loaded && cache->magic == DETECTION_CACHE_MAGIC && cache->version == DETECTION_CACHE_VERSION &&
+           cache->checksum == detectionCacheChecksum(cache);
+}
+
+void Sensors::saveDetectionCache(int pms_type, int pms_rx, int pms_tx, bool uart_detected) {
+    SensorsCache cache;
+    memset(&cache, 0, sizeof(cache));
+    cache.magic = DETECTION_CACHE_MAGIC;
+    cache.version = DETECTION_CACHE_VERSION;
+    cache.pms_type = pms_type;
+    cache.uart_type = uart_detected ? dev_uart_type : -1;
+    cache.pms_rx = pms_rx;
+    cache.pms_tx = pms_tx;
+    cache.uart_baud = uart_baud;
+    cache.drivers = drivers_detected;
+    cache.checksum = detectionCacheChecksum(&cache);
+#ifdef ARDUINO_ARCH_ESP32
+    bool changed = memcmp(&rtc_detection_cache, &cache, sizeof(cache)) != 0;
+    rtc_detection_cache = cache;
+    if (!changed) return;  // avoid NVS writes on each wake up
+    Preferences preferences;
+    preferences.begin("sensorlib", false);
+    preferences.putBytes("detection", &cache, sizeof(cache));
+    preferences.end();
+#elif defined(ARDUINO_ARCH_ESP8266)
+    ESP.rtcUserMemoryWrite(SENSORLIB_RTC_OFFSET, (uint32_t *)&cache, sizeof(cache));
+#endif
+    DEBUG("-->[SLIB] detection cache saved\t: ", uartDeviceName(cache.uart_type));
+}
+
 void Sensors::printUnitsRegistered() { 
     if (!devmode) return;
     Serial.printf("-->[SLIB] Sensors units count\t: %i\n", units_registered_count);
     Serial.print("-->[SLIB] Units registered   \t: ");
-    int i = 0;
-    while (units_registered[i++] != 0) {
-        Serial.print(unit_name[units_registered[i-1]]);
+    for (int i = 0; i < units_registered_count; i++) {
+        Serial.print(unitName((UNIT)units_registered[i]));
         Serial.print(",");
     }
     Serial.println();
@@ -1354,14 +3323,33 @@ void Sensors::resetAllVariables() {
     pm1 = 0;
     pm25 = 0;
     pm10 = 0;
+    pm1c = 0;
+    pm25c = 0;
+    pm4c = 0;
+    pm10c = 0;
     CO2Val = 0;
-    CO2humi = 0.0;
-    CO2temp = 0.0;
-    humi = 0.0;
-    temp = 0.0;
-    alt = 0.0;
-    gas = 0.0;
-    pres = 0.0;
+    CO2humi = 0;
+    CO2temp = 0;
+    humi = 0;
+    temp = 0;
+    alt = 0;
+    gas = 0;
+    pres = 0;
+    npm05 = 0;
+    npm1 = 0;
+    npm25 = 0;
+    npm4 = 0;
+    npm10 = 0;
+    psize = 0;
+    pm1a = 0;
+    pm25a = 0;
+    pm10a = 0;
+    cnt03 = 0;
+    cnt05 = 0;
+    cnt1 = 0;
+    cnt25 = 0;
+    cnt5 = 0;
+    cnt10 = 0;
 }
 
 void Sensors::DEBUG(const char *text, const char *textb) {
@@ -1377,6 +3365,7 @@ void Sensors::DEBUG(const char *text, const char *textb) {
 
 bool Sensors::serialInit(int pms_type, unsigned long speed_baud, int pms_rx, int pms_tx) {
     if(devmode)Serial.printf("-->[SLIB] UART init with speed\t: %lu RX:%i TX:%i\n", speed_baud, pms_rx, pms_tx);
+    uart_baud = speed_baud;
     switch (SENSOR_COMMS) {
         case SERIALPORT:
             Serial.begin(speed_baud);
@@ -1414,16 +3403,18 @@ bool Sensors::serialInit(int pms_type, unsigned long speed_baud, int pms_rx, int
                 DEBUG("-->[SLIB] TX/RX line not defined");
                 return false;
             }
-            Serial1.begin(speed_baud, SERIAL_8N1, pms_rx, pms_tx, false);
+            Serial1.begin(speed_baud, uart_config, pms_rx, pms_tx, false);
             _serial = &Serial1;
+            uart_hw_serial = &Serial1;
             break;
 
         case SERIALPORT2:
             if (pms_type == SSPS30)
                 Serial2.begin(speed_baud);
             else
-                Serial2.begin(speed_baud, SERIAL_8N1, pms_rx, pms_tx, false);
+                Serial2.begin(speed_baud, uart_config, pms_rx, pms_tx, false);
             _serial = &Serial2;
+            uart_hw_serial = &Serial2;
             break;
 #endif
         default:
@@ -1445,7 +3436,7 @@ bool Sensors::serialInit(int pms_type, unsigned long speed_baud, int pms_rx, int
                 static SoftwareSerial swSerial(pms_rx, pms_tx);
                 if (pms_type == SSPS30)
                     swSerial.begin(speed_baud);
-                else if (pms_type == Panasonic)
+                else if (pms_type == Panasonic || uart_config == SERIAL_8E1)
                     swSerial.begin(speed_baud, SWSERIAL_8E1, pms_rx, pms_tx, false);
                 else
                     swSerial.begin(speed_baud, SWSERIAL_8N1, pms_rx, pms_tx, false);
@@ -8,6 +8,7 @@
 #include <Adafruit_BME680.h>
 #include <Adafruit_SHT31.h>
 #include <Adafruit_Sensor.h>
+#include <Adafruit_I2CDevice.h>
 #include <MHZ19.h>
 #include <SparkFun_SCD30_Arduino_Library.h>
 #include <SparkFun_Particle_Sensor_SN-GCJA5_Arduino_Library.h>
@@ -15,7 +16,14 @@
 #include <sps30.h>
 #include <cm1106_uart.h>
 #include <s8_uart.h>
+#include <SensirionCore.h>
 #include <SensirionI2CScd4x.h>
+#include "SensorFrames.hpp"
+#include "UARTReceiver.hpp"
+#include "UnitPipeline.hpp"
+#ifdef ARDUINO_ARCH_ESP32
+#include <Preferences.h>
+#endif
 
 #define CSL_VERSION "0.4.3"
 #define CSL_REVISION  342
@@ -68,35 +76,384 @@
 // Read UART sensor retry. 
 #define SENSOR_RETRY 1000         // Max Serial characters
 
+// Extra UART sensors (i.e. PM and CO2 sensors on separate serial ports)
+#define UART_SLOTS_MAX 2
+
+// UART receive on the events of the ESP32 UART driver (onReceive, core 2.0.3 onwards)
+#if defined(ARDUINO_ARCH_ESP32) && defined(ESP_ARDUINO_VERSION_VAL)
+#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(2, 0, 3)
+#define UART_RX_EVENTS
+#endif
+#endif
+
+// UART concurrent autodetection
+#define UART_DETECT_WINDOW 1200   // max listening window for the first valid frame (ms)
+#define UART_DETECT_PROBE_GAP 20  // gap between CO2 probe commands (ms)
+#define UART_SNIFF_WINDOW 1100    // listening window for each baud rate and framing (ms)
+#define UART_SNIFF_BUFFER 128     // bytes recorded for each baud rate and framing
+
 // Sensirion SPS30 sensor
 #define SENSOR_COMMS SERIALPORT2  // UART OR I2C
+#define SPS30_I2C_ADDRESS 0x69
 
 //H&T definitions
 #define SEALEVELPRESSURE_HPA (1013.25)
 
-#define SENSOR_UNITS         \
-    X(NUNIT, "NUNIT", "NUNIT")    \
-    X(PM1, "ug/m3", "PM1")    \
-    X(PM25, "ug/m3", "PM2.5")   \
-    X(PM4, "ug/m3", "PM4")   \
-    X(PM10, "ug/m3", "PM10")    \
-    X(TEMP, "C", "Temp")     \
-    X(HUM, "%", "Hum")        \
-    X(CO2, "ppm", "CO2")      \
-    X(CO2TEMP, "C", "CO2T")  \
-    X(CO2HUM, "%", "CO2H")    \
-    X(PRESS, "hPa", "Press")   \
-    X(ALT, "m", "Alt")       \
-    X(GAS, "Ohm", "Gas") 
-
-#define MAX_UNITS_SUPPORTED 13   // Max number of units supported (TODO: make dynamic)
-
-#define X(unit, symbol, name) unit, 
-typedef enum UNIT : size_t { SENSOR_UNITS } UNIT;
+// Units of the registry (unit, symbol, name, scale, storage slot). Scale is the
+// resolution of the values: 1 for integer units, UNIT_VALUE_SCALE for hundredths
+#define SENSOR_UNITS                               \
+    X(NUNIT, "NUNIT", "NUNIT", 1, nullptr)            \
+    X(PM1, "ug/m3", "PM1", 1, &Sensors::pm1)          \
+    X(PM25, "ug/m3", "PM2.5", 1, &Sensors::pm25)      \
+    X(PM4, "ug/m3", "PM4", 1, &Sensors::pm4)          \
+    X(PM10, "ug/m3", "PM10", 1, &Sensors::pm10)       \
+    X(TEMP, "C", "Temp", 100, &Sensors::temp)         \
+    X(HUM, "%", "Hum", 100, &Sensors::humi)           \
+    X(CO2, "ppm", "CO2", 1, &Sensors::CO2Val)         \
+    X(CO2TEMP, "C", "CO2T", 100, &Sensors::CO2temp)   \
+    X(CO2HUM, "%", "CO2H", 100, &Sensors::CO2humi)    \
+    X(PRESS, "hPa", "Press", 100, &Sensors::pres)     \
+    X(ALT, "m", "Alt", 100, &Sensors::alt)            \
+    X(GAS, "Ohm", "Gas", 100, &Sensors::gas)          \
+    X(PM1C, "ug/m3", "PM1c", 100, &Sensors::pm1c)     \
+    X(PM25C, "ug/m3", "PM2.5c", 100, &Sensors::pm25c) \
+    X(PM4C, "ug/m3", "PM4c", 100, &Sensors::pm4c)     \
+    X(PM10C, "ug/m3", "PM10c", 100, &Sensors::pm10c)  \
+    X(NPM05, "#/cm3", "NPM0.5", 100, &Sensors::npm05) \
+    X(NPM1, "#/cm3", "NPM1", 100, &Sensors::npm1)     \
+    X(NPM25, "#/cm3", "NPM2.5", 100, &Sensors::npm25) \
+    X(NPM4, "#/cm3", "NPM4", 100, &Sensors::npm4)     \
+    X(NPM10, "#/cm3", "NPM10", 100, &Sensors::npm10)  \
+    X(PSIZE, "um", "PSize", 100, &Sensors::psize)     \
+    X(PM1A, "ug/m3", "PM1a", 1, &Sensors::pm1a)       \
+    X(PM25A, "ug/m3", "PM2.5a", 1, &Sensors::pm25a)   \
+    X(PM10A, "ug/m3", "PM10a", 1, &Sensors::pm10a)    \
+    X(CNT03, "#/0.1L", "CNT0.3", 1, &Sensors::cnt03)  \
+    X(CNT05, "#/0.1L", "CNT0.5", 1, &Sensors::cnt05)  \
+    X(CNT1, "#/0.1L", "CNT1", 1, &Sensors::cnt1)      \
+    X(CNT25, "#/0.1L", "CNT2.5", 1, &Sensors::cnt25)  \
+    X(CNT5, "#/0.1L", "CNT5", 1, &Sensors::cnt5)      \
+    X(CNT10, "#/0.1L", "CNT10", 1, &Sensors::cnt10)
+
+// Max number of units: built-in and registered at runtime (registerUnit)
+#ifndef SENSORLIB_MAX_UNITS
+#define SENSORLIB_MAX_UNITS 48
+#endif
+#define MAX_UNITS_SUPPORTED SENSORLIB_MAX_UNITS
+
+#define X(unit, symbol, name, scale, slot) unit,
+typedef enum UNIT : size_t { SENSOR_UNITS UNITS_BUILTIN } UNIT;
 #undef X
 
+static_assert(MAX_UNITS_SUPPORTED >= UNITS_BUILTIN && MAX_UNITS_SUPPORTED <= 65535,
+              "SENSORLIB_MAX_UNITS: from built-in units to 65535 (uint16 unit counters)");
+
+/**
+ * Set of units, one bit for each unit of the registry (SENSORLIB_MAX_UNITS).
+ * Used for the units of each driver and the units changed on the last round.
+ */
+class UnitsMask {
+   public:
+    void set(UNIT unit) { words[unit / 32] |= 1UL << (unit % 32); }
+    void reset(UNIT unit) { words[unit / 32] &= ~(1UL << (unit % 32)); }
+    bool test(UNIT unit) const { return unit < MAX_UNITS_SUPPORTED && (words[unit / 32] & (1UL << (unit % 32))); }
+    void clear() { memset(words, 0, sizeof(words)); }
+    bool any() const {
+        for (uint32_t word : words) {
+            if (word != 0) return true;
+        }
+        return false;
+    }
+
+   private:
+    uint32_t words[(MAX_UNITS_SUPPORTED + 31) / 32] = {};
+};
+
+/**
+ * Post-processing stages of each unit (see UnitPipeline.hpp). Without editing
+ * the library, users could append stages to any unit specializing UserStages
+ * on a sensorlib_stages.h header in the project include path, i.e.:
+ * template <> struct UserStages<PM25> { typedef Pipeline<LinearStage, ClampStage> type; };
+ */
+template <UNIT U>
+struct UserStages {
+    typedef Pipeline<> type;
+};
+
+#ifdef __has_include
+#if __has_include(<sensorlib_stages.h>)
+#include <sensorlib_stages.h>
+#endif
+#endif
+
+template <UNIT U>
+struct UnitStages {
+    typedef Pipeline<typename UserStages<U>::type> type;
+};
+
+template <>
+struct UnitStages<PM1> {
+    typedef Pipeline<HampelStage, CalibrationStage, UserStages<PM1>::type> type;
+};
+
+template <>
+struct UnitStages<PM25> {
+    typedef Pipeline<HampelStage, CalibrationStage, UserStages<PM25>::type> type;
+};
+
+template <>
+struct UnitStages<PM4> {
+    typedef Pipeline<HampelStage, CalibrationStage, UserStages<PM4>::type> type;
+};
+
+template <>
+struct UnitStages<PM10> {
+    typedef Pipeline<HampelStage, CalibrationStage, UserStages<PM10>::type> type;
+};
+
+template <>
+struct UnitStages<TEMP> {
+    typedef Pipeline<CalibrationStage, OffsetStage, UserStages<TEMP>::type> type;
+};
+
+template <>
+struct UnitStages<CO2TEMP> {
+    typedef Pipeline<OffsetStage, UserStages<CO2TEMP>::type> type;
+};
+
+template <>
+struct UnitStages<HUM> {
+    typedef Pipeline<CalibrationStage, UserStages<HUM>::type> type;
+};
+
+template <>
+struct UnitStages<CO2> {
+    typedef Pipeline<HampelStage, CO2PressureStage, CalibrationStage, UserStages<CO2>::type> type;
+};
+
+template <UNIT U>
+struct UnitPipelineStorage {
+    static typename UnitStages<U>::type pipeline;
+};
+
+template <UNIT U>
+typename UnitStages<U>::type UnitPipelineStorage<U>::pipeline;
+
+/// pipeline of one unit, for stages access: unitPipeline<TEMP>().stage<OffsetStage>()
+template <UNIT U>
+inline typename UnitStages<U>::type &unitPipeline() {
+    return UnitPipelineStorage<U>::pipeline;
+}
+
+/// one inlined pass of all stages of the unit, from a sensor reading
+template <UNIT U, typename T>
+inline svalue_t processUnit(T value) {
+    return UnitPipelineStorage<U>::pipeline.process(toSValue(value));
+}
+
+/// one pass for integer units (PM and CO2), rounded and limited to uint16
+template <UNIT U, typename T>
+inline uint16_t processUnitU16(T value) {
+    return toU16(processUnit<U>(value));
+}
+
+// DHT sensors are polled before the sample round, until they have a sample (ms)
+#define DHT_LEAD_TIME 4000
+
+// BME680 conversion (with gas heater) is started before the sample round (ms)
+#define BME680_LEAD_TIME 300
+
+/**
+ * Sensor drivers in init order, the last one detected with a device name is
+ * the main device. Columns: driver, name, main device, units provided (the
+ * first one is the primary unit), I2C address and alternative address for
+ * the probe (0 without probe, the same address is probed again after a wake
+ * up), max I2C clock kHz or 0, min sample period (s), start lead time (ms),
+ * init, start and read.
+ */
+#define SENSOR_DRIVERS                                                                                              \
+    X(DRIVER_UART, "UART", nullptr, (NUNIT), 0, 0, 0, 0, SDS011_WARMUP, uartDriverInit, uartDriverStart,            \
+      uartDriverRead)                                                                                               \
+    X(DRIVER_SPS30, "SPS30", "SENSIRION", (PM25, PM1, PM4, PM10, NPM05, NPM1, NPM25, NPM4, NPM10, PSIZE),           \
+      SPS30_I2C_ADDRESS, 0, 100, 0, 0, sps30I2CInit, driverNoStart, sps30DriverRead)                                \
+    X(DRIVER_GCJA5, "GCJA5", "PANASONIC_I2C", (PM25, PM1, PM10), 0x33, 0, 100, 0, 0, PMGCJA5Init, driverNoStart,    \
+      PMGCJA5Read)                                                                                                  \
+    X(DRIVER_AM2320, "AM2320", nullptr, (TEMP, HUM), 0x5C, 0x5C, 100, 0, 0, am2320Init, driverNoStart, am2320Read)  \
+    X(DRIVER_SHT31, "SHT31", nullptr, (TEMP, HUM), 0x44, 0x45, 400, 0, 0, sht31Init, driverNoStart, sht31Read)      \
+    X(DRIVER_BME280, "BME280", nullptr, (TEMP, HUM, PRESS, ALT), 0x77, 0x76, 400, 0, 0, bme280Init, driverNoStart,  \
+      bme280Read)                                                                                                   \
+    X(DRIVER_BMP280, "BMP280", nullptr, (PRESS, TEMP, ALT), 0x77, 0x76, 400, 0, 0, bmp280Init, driverNoStart,       \
+      bmp280Read)                                                                                                   \
+    X(DRIVER_BME680, "BME680", nullptr, (TEMP, HUM, PRESS, GAS, ALT), 0x77, 0x76, 400, 0, BME680_LEAD_TIME,         \
+      bme680Init, bme680Start, bme680Read)                                                                          \
+    X(DRIVER_AHT10, "AHT10", nullptr, (TEMP, HUM), 0x38, 0, 400, 0, 0, aht10Init, driverNoStart, aht10Read)         \
+    X(DRIVER_DHT, "DHT", nullptr, (TEMP, HUM), 0, 0, 0, 0, DHT_LEAD_TIME, dhtInit, dhtStart, dhtRead)              \
+    X(DRIVER_SCD30, "SCD30", "SCD30", (CO2, CO2TEMP, CO2HUM), 0x61, 0, 100, 0, 0, CO2scd30Init, driverNoStart,      \
+      CO2scd30Read)                                                                                                 \
+    X(DRIVER_SCD4X, "SCD4x", "SCD4x", (CO2, CO2TEMP, CO2HUM), SCD4X_I2C_ADDRESS, 0, 400, 5, 0, CO2scd4xInit,       \
+      driverNoStart, CO2scd4xRead)
+
+#define X(driver, name, device, units, address, alt, khz, period, lead, init, start, read) driver,
+typedef enum SENSOR_DRIVER : uint8_t { SENSOR_DRIVERS DRIVER_COUNT } SENSOR_DRIVER;
+#undef X
+
+// External drivers (out of the library) registered with SENSORLIB_DRIVER, after the built-in drivers
+#ifndef SENSORLIB_EXTERNAL_DRIVERS
+#define SENSORLIB_EXTERNAL_DRIVERS 4
+#endif
+#define DRIVERS_MAX (DRIVER_COUNT + SENSORLIB_EXTERNAL_DRIVERS)
+
+// Extra I2C buses and TCA9548A/TCA9546A multiplexers (sensor instances)
+#define I2C_BUS_MAX 2              // extra TwoWire buses, without the main Wire
+#define I2C_MUX_MAX 4              // multiplexers, on any bus
+#define I2C_MUX_CHANNELS 8
+#define I2C_MUX_ADDRESS 0x70       // default TCA954x address (0x70 to 0x77)
+#define SENSOR_INSTANCES_MAX 8     // sensors found on extra buses and mux channels
+#define INSTANCE_UNITS_MAX 4       // units of one instance (BME280)
+#define INSTANCE_NAME_MAX 12       // unit name of one instance, i.e. "Temp.1"
+
+// Sources of readings: the drivers (main sensors), the sensor instances, then the extra UART sensors
+#define UART_SOURCES_FIRST (DRIVERS_MAX + SENSOR_INSTANCES_MAX)
+#define SOURCES_MAX (UART_SOURCES_FIRST + UART_SLOTS_MAX)
+
+static_assert(SOURCES_MAX <= 32, "SENSORLIB_EXTERNAL_DRIVERS: source masks are uint32");
+
+class Sensors;
+
+/**
+ * Context of one source, the main sensor of a driver or a sensor instance
+ * found on an extra I2C bus or a mux channel, with its own driver object.
+ * Instances are supported by SHT31, BME280, SCD30 and SCD4x. The extra UART
+ * sensors are sources too, with its slot as device.
+ */
+typedef struct SensorInstance {
+    SENSOR_DRIVER driver;
+    TwoWire *bus;
+    int8_t mux;            // index of the mux, -1 without mux
+    int8_t channel;        // mux channel, -1 without mux
+    uint8_t address;       // I2C address found by its probe
+    union {
+        Adafruit_SHT31 *sht31;
+        Adafruit_BME280 *bme280;
+        SCD30 *scd30;
+        SensirionI2CScd4x *scd4x;
+        UARTSlot *uart;
+    } device;
+    UNIT units_first;      // runtime unit of the first unit of its source (instances and UART), NUNIT on main sensors
+    uint8_t variant;       // sensor variant (SCD4X_VARIANT_*)
+    uint8_t mode;          // measurement mode running (SCD4X_MODE_*)
+} SensorInstance;
+
+/**
+ * Sensor driver interface: a static table of plain functions, without
+ * virtual calls. Built-in drivers are on SENSOR_DRIVERS and external
+ * drivers are defined with SensorDriver<> (see the end of this file).
+ */
+typedef struct DriverOps {
+    const char *name;
+    const char *device;                 // main device on its detection (getMainDeviceSelected), nullptr without it
+    UNIT unit;                          // primary unit (adaptive sampling)
+    const UNIT *units;                  // units provided, ended with NUNIT (nullptr if they are not known)
+    uint8_t address;                    // I2C address, 0 if it is not an I2C sensor
+    uint16_t period;                    // min sample period (s), 0 is the sample time
+    uint16_t lead;                      // start time before the sample round (ms), 0 starts on the round
+    bool (*probe)(Sensors &sensors, SensorInstance &instance);    // cheap presence check before init, nullptr without it
+    bool (*init)(Sensors &sensors, SensorInstance &instance);     // true if the sensor was found
+    bool (*start)(Sensors &sensors, SensorInstance &instance);    // measurement start before the read, true when it is started
+    bool (*collect)(Sensors &sensors, SensorInstance &instance);  // read, units are published with setUnitValue()
+} DriverOps;
+
+// Adaptive sampling: EWMA weight and fast change detection (integer percents)
+#define ADAPTIVE_EWMA_ALPHA 30   // weight of the new sample on mean/variance (%)
+#define ADAPTIVE_FAST_SIGMAS 3   // deviations (sigma) for a fast change
+#define ADAPTIVE_STABLE_REL 2    // relative deviation to consider it stable (%)
+#define ADAPTIVE_FAST_REL 10     // relative change to consider it fast (%)
+
+// Live barometric CO2 compensation
+#define PRESSURE_EWMA_ALPHA 20             // weight of the new pressure sample (%)
+#define CO2_PRESSURE_PUSH_INTERVAL 60000   // min time between SCD30/SCD4x pressure updates (ms)
+#define CO2_PRESSURE_PUSH_DELTA 1          // min pressure change to update SCD30/SCD4x (hPa)
+
+// Fusion weight of each source, Q8 (256 is 1.0)
+#define SOURCE_WEIGHT_ONE 256
+#define SOURCE_FRESH_PERIODS 2  // a source sample is fused up to 2 sample periods of its driver
+
+// PM hygroscopic growth correction (kappa-Kohler)
+#define PM_KAPPA_DEFAULT 0.4   // hygroscopicity of the aerosol
+#define PM_LUT_RH_MAX 99       // humidity table from 0 to 99%
+
+// Detection cache (warm boot without autodetection)
+#define DETECTION_CACHE_MAGIC 0x43534C44  // "CSLD"
+#define DETECTION_CACHE_VERSION 3
+#define DETECTION_CACHE_TIMEOUT 1500      // max wait for a frame on the cached probe (ms)
+
+// Nova SDS011 fan warm up before a read in sleep mode (ms)
+#define SDS011_WARMUP 30000
+
+// Measurement profiles
+#define PROFILE_LOW_POWER_SAMPLE_TIME 60  // min sample time on low power profile (s)
+#define SCD4X_I2C_ADDRESS 0x62
+
+// SCD4x variants (get_sensor_variant) and measurement modes
+#define SCD4X_VARIANT_SCD40 0
+#define SCD4X_VARIANT_SCD41 1
+#define SCD4X_VARIANT_SCD43 5
+#define SCD4X_MODE_IDLE 0
+#define SCD4X_MODE_PERIODIC 1      // 5 s period
+#define SCD4X_MODE_LOW_POWER 2     // low power periodic, 30 s period (SCD40)
+#define SCD4X_MODE_SINGLE_SHOT 3   // one measurement for each read (SCD41 and SCD43)
+
+// I2C bus management
+#define I2C_CLOCK_DEFAULT 100      // bus clock for the detection (kHz)
+#define I2C_BUS_TIME_ALPHA 30      // weight of the new read on the bus time of each source (%)
+
+// Driver health: consecutive failures to start the exponential backoff
+#define HEALTH_FAIL_THRESHOLD 3
+#define HEALTH_BACKOFF_MAX 6      // max backoff level, retry each 2^6 sample periods
+
+// Health of one sensor driver (see getDriverHealth)
+typedef struct DriverHealth {
+    uint16_t failures;      // consecutive reads without data
+    uint32_t last_success;  // millis() of the last read with data
+    uint8_t backoff;        // level, it is retried each 2^level sample periods
+    uint32_t retry_time;    // millis() of the next retry
+} DriverHealth;
+
+// I2C multiplexer (TCA954x)
+typedef struct I2CMux {
+    TwoWire *bus;
+    uint8_t address;
+} I2CMux;
+
+// Sensors detected on the last init, persisted in RTC memory and NVS
+typedef struct SensorsCache {
+    uint32_t magic;
+    uint8_t version;
+    int8_t pms_type;        // UART type requested on init
+    int8_t uart_type;       // UART sensor detected (-1 none)
+    int8_t pms_rx;
+    int8_t pms_tx;
+    uint32_t uart_baud;
+    uint32_t drivers;       // I2C drivers detected (bit N is SENSOR_DRIVER N)
+    uint8_t checksum;
+} SensorsCache;
+
+// ESP8266 RTC user memory offset of the detection cache, in 4 bytes blocks. The
+// library reserves the last blocks (the first 32 are lost on OTA updates)
+#ifndef SENSORLIB_RTC_OFFSET
+#define SENSORLIB_RTC_OFFSET (128 - (sizeof(SensorsCache) + 3) / 4)
+#endif
+
+// Unit value of the bulk export (see getUnitsValues)
+typedef struct UnitValue {
+    UNIT unit;
+    int32_t value;       // hundredths (UNIT_VALUE_SCALE)
+    uint32_t timestamp;  // millis() of the sensor read
+} UnitValue;
+
 typedef void (*errorCbFn)(const char *msg);
 typedef void (*voidCbFn)();
+typedef void (*unitsChangedCbFn)(const UnitsMask &changed);
 
 class Sensors {
    public:
@@ -104,6 +461,12 @@ class Sensors {
     // UART sensors supported
     enum UART_SENSOR_TYPE { Auto, Panasonic, SSPS30, SDS011, Mhz19, CM1106, SENSEAIRS8, SSCD30, SSCD4x };
 
+    // Temperature and humidity fusion of multiple sources
+    enum FUSION_MODE { FUSION_LAST, FUSION_MEAN, FUSION_MEDIAN };
+
+    // Measurement profiles of the drivers (see setMeasurementProfile)
+    enum MEASURE_PROFILE { PROFILE_DEFAULT, PROFILE_LOW_LATENCY, PROFILE_LOW_POWER, PROFILE_HIGH_PRECISION };
+
     // MAIN SENSOR TYPE
     enum MAIN_SENSOR_TYPE { SENSOR_NONE, SENSOR_PM, SENSOR_CO2 };
 
@@ -154,7 +517,7 @@ class Sensors {
     // SCD30 sensor
     SCD30 scd30;
     // CM1106 UART
-    CM1106_UART *cm1106;
+    CM1106_UART *cm1106 = nullptr;
 
     CM1106_sensor cm1106sensor;
 
@@ -162,7 +525,7 @@ class Sensors {
     // Panasonic SN-GCJA5
     SFE_PARTICLE_SENSOR pmGCJA5;
     // SenseAir S8 CO2 sensor
-    S8_UART *s8;
+    S8_UART *s8 = nullptr;
 
     S8_sensor s8sensor;
     // SCD4x sensor
@@ -180,6 +543,76 @@ class Sensors {
 
     void setOnErrorCallBack(errorCbFn cb);
 
+    void setOnChangedCallBack(unitsChangedCbFn cb);
+
+    void setOnFrameCallBack(frameCbFn cb);
+
+    void setUnitDeadband(UNIT unit, float absolute, float relative = 0.0);
+
+    void setMaxSilenceTime(int seconds);
+
+    const UnitsMask &getChangedUnits();
+
+    void setDetectionCache(bool enable);
+
+    void setUARTAutoBaud(bool enable);
+
+    void clearDetectionCache();
+
+    void setAdaptiveSampling(bool enable, int min_seconds = 5, int max_seconds = 60);
+
+    int getDriverSampleTime(SENSOR_DRIVER driver);
+
+    String getDriverName(SENSOR_DRIVER driver);
+
+    UnitsMask getDriverUnits(SENSOR_DRIVER driver);
+
+    void setDriverBackoff(bool enable);
+
+    DriverHealth getDriverHealth(SENSOR_DRIVER driver);
+
+    bool isDriverHealthy(SENSOR_DRIVER driver);
+
+    void setI2CClock(SENSOR_DRIVER driver, uint16_t khz);
+
+    uint32_t getI2CClock();
+
+    void setI2CBusBudget(int milliseconds);
+
+    uint32_t getI2CBusTime(SENSOR_DRIVER driver);
+
+    uint32_t getI2CBusUsage();
+
+    bool addI2CBus(TwoWire *bus);
+
+    bool addI2CMux(TwoWire *bus = &Wire, uint8_t address = I2C_MUX_ADDRESS);
+
+    uint8_t getInstancesCount();
+
+    SENSOR_DRIVER getInstanceDriver(uint8_t instance);
+
+    int getInstanceChannel(uint8_t instance);
+
+    UNIT getInstanceUnit(uint8_t instance, UNIT unit);
+
+    uint32_t getInstanceTimestamp(uint8_t instance);
+
+    void setTHFusionMode(FUSION_MODE mode);
+
+    void setMeasurementProfile(MEASURE_PROFILE profile);
+
+    MEASURE_PROFILE getMeasurementProfile();
+
+    void setSourceWeight(SENSOR_DRIVER driver, float weight);
+
+    bool isTemperatureSource(SENSOR_DRIVER driver);
+
+    bool isHumiditySource(SENSOR_DRIVER driver);
+
+    float getSourceTemperature(SENSOR_DRIVER driver);
+
+    float getSourceHumidity(SENSOR_DRIVER driver);
+
     void setDebugMode(bool enable);
 
     void setDHTparameters(int dht_sensor_pin = DHT_SENSOR_PIN, int dht_sensor_type = DHT_SENSOR_TYPE);
@@ -188,6 +621,16 @@ class Sensors {
 
     int getUARTDeviceTypeSelected();
 
+    bool addUARTSensor(int type, Stream *serial);
+
+#ifdef ARDUINO_ARCH_ESP32
+    bool addUARTSensor(int type, HardwareSerial *serial, int rx, int tx);
+#endif
+
+    uint8_t getUARTSensorsCount();
+
+    UNIT getUARTSensorUnit(uint8_t slot, UNIT unit);
+
     String getMainDeviceSelected();
 
     int getMainSensorTypeSelected();
@@ -200,6 +643,48 @@ class Sensors {
 
     uint16_t getPM10();
 
+    uint16_t getPM1Corrected();
+
+    uint16_t getPM25Corrected();
+
+    uint16_t getPM4Corrected();
+
+    uint16_t getPM10Corrected();
+
+    void setPMHumidityCorrection(bool enable, float kappa = PM_KAPPA_DEFAULT);
+
+    uint16_t getPM1Atm();
+
+    uint16_t getPM25Atm();
+
+    uint16_t getPM10Atm();
+
+    uint16_t getCount03();
+
+    uint16_t getCount05();
+
+    uint16_t getCount1();
+
+    uint16_t getCount25();
+
+    uint16_t getCount5();
+
+    uint16_t getCount10();
+
+    float getNumPM05();
+
+    float getNumPM1();
+
+    float getNumPM25();
+
+    float getNumPM4();
+
+    float getNumPM10();
+
+    float getPartSize();
+
+    void setSPS30MassOnly(bool enable);
+
     uint16_t getCO2();
 
     float getCO2humi();
@@ -220,6 +705,24 @@ class Sensors {
     
     void setCO2AltitudeOffset(float altitude);
 
+    void setCO2PressureCompensation(bool enable);
+
+    bool setCalibrationCurve(UNIT unit, const float *x, const float *y, uint8_t points);
+
+    void clearCalibrationCurve(UNIT unit);
+
+    bool setOutlierFilter(UNIT unit, bool enable, float sigmas = HAMPEL_SIGMAS_DEFAULT, float min_deviation = 0.0);
+
+    bool isUnitOutlier(UNIT unit);
+
+    uint32_t getUnitOutliers(UNIT unit);
+
+    bool saveCalibrationCurves();
+
+    void loadCalibrationCurves();
+
+    float getCO2CompensationPressure();
+
     String getFormatTemp();
 
     String getFormatPress();
@@ -250,7 +753,7 @@ class Sensors {
     
     int16_t getLibraryRevision();
 
-    uint8_t getUnitsRegisteredCount();
+    uint16_t getUnitsRegisteredCount();
 
     bool isUnitRegistered(UNIT unit);
 
@@ -262,84 +765,292 @@ class Sensors {
 
     uint32_t getUnitValue(UNIT unit);
 
+    int32_t getUnitValueScaled(UNIT unit);
+
+    float getUnitFloatValue(UNIT unit);
+
+    uint16_t getUnitsValues(UnitValue *values, uint16_t size);
+
+    uint32_t getUnitTimestamp(UNIT unit);
+
+    UNIT registerUnit(const char *symbol, const char *name, uint16_t scale = UNIT_VALUE_SCALE);
+
+    bool setUnitValue(UNIT unit, float value);
+
+    uint16_t getUnitsCount();
+
+    uint16_t getUnitScale(UNIT unit);
+
+    static bool registerDriver(const DriverOps *ops);
+
    private:
+    /// Storage slot of one unit value (a member), uint16 or svalue_t
+    struct UnitSlot {
+        uint16_t Sensors::*u16;
+        svalue_t Sensors::*value;
+    };
+
+    /// Unit descriptor of the registry
+    struct UnitDescriptor {
+        UNIT unit;
+        const char *symbol;
+        const char *name;
+        uint16_t scale;  // resolution of the values: 1 integer, UNIT_VALUE_SCALE hundredths
+        UnitSlot slot;
+    };
+
+    static constexpr UnitSlot unitSlot(uint16_t Sensors::*u16) { return {u16, nullptr}; }
+    static constexpr UnitSlot unitSlot(svalue_t Sensors::*value) { return {nullptr, value}; }
+    static constexpr UnitSlot unitSlot(std::nullptr_t) { return {nullptr, nullptr}; }
+
+    /// built-in units, indexed by UNIT (constant table)
+    static const UnitDescriptor unit_descriptors[UNITS_BUILTIN];
+
     /// DHT library
     uint32_t delayMS;
     /// For UART sensors (autodetected available serial)
-    Stream *_serial;
+    Stream *_serial = nullptr;
     /// Callback on some sensors error.
     errorCbFn _onErrorCb = nullptr;
     /// Callback when sensor data is ready.
     voidCbFn _onDataCb = nullptr;
+    /// Callback when some unit moved beyond its deadband (or heartbeat).
+    unitsChangedCbFn _onChangedCb = nullptr;
+    /// Callback when a valid UART frame is received (UART task on events).
+    frameCbFn _onFrameCb = nullptr;
 
     String device_selected;
     int dev_uart_type = -1;
     bool dataReady;
 
-    uint8_t units_registered_count;
-    uint8_t current_unit = 0;
+    uint16_t units_registered_count;
+    uint16_t current_unit = 0;
+    UnitsMask units_registered_mask;  // units of units_registered, O(1) lookup
+
+    // units registered at runtime, UNITS_BUILTIN onwards
+    UnitDescriptor unit_dynamic_descriptors[MAX_UNITS_SUPPORTED - UNITS_BUILTIN];
+    svalue_t unit_dynamic[MAX_UNITS_SUPPORTED - UNITS_BUILTIN] = {};
+    uint16_t units_dynamic_count = 0;
+    UnitsMask units_value_set;  // units set out of a driver read, for the next round
+
+    // snapshot of the last sample round for the bulk export
+    uint32_t unit_timestamp[MAX_UNITS_SUPPORTED] = {};
+    UnitValue units_snapshot[MAX_UNITS_SUPPORTED];
+    uint16_t units_snapshot_count = 0;
+
+    // change-driven reporting (deadbands per unit)
+    svalue_t unit_deadband_abs[MAX_UNITS_SUPPORTED] = {};
+    uint16_t unit_deadband_rel[MAX_UNITS_SUPPORTED] = {};  // per mille
+    svalue_t unit_last_reported[MAX_UNITS_SUPPORTED] = {};
+    UnitsMask units_reported;  // units reported at least once
+    UnitsMask changed_units;   // units changed in the last sample round
+    uint32_t max_silence = 0;     // max time without report (ms), 0 disabled
+    uint32_t last_report_time = 0;
+
+    // adaptive sampling (per source: drivers and sensor instances)
+    bool adaptive_sampling = false;
+    uint32_t sample_min = 5000;   // fastest period (ms)
+    uint32_t sample_max = 60000;  // slowest period (ms)
+    uint32_t driver_interval[SOURCES_MAX] = {};
+    uint32_t driver_last_read[SOURCES_MAX] = {};
+    svalue_t driver_ewma[SOURCES_MAX] = {};
+    saccum_t driver_ewvar[SOURCES_MAX] = {};
+    UnitsMask driver_units[SOURCES_MAX];  // units registered by each source
+    UnitsMask driver_units_prev;          // units of the previous read of the current source
+    bool driver_units_kept = false;            // the current source has not new data
+    uint8_t current_source = SOURCES_MAX;      // source on read, SOURCES_MAX out of a read
+    bool sds011_sleeping = false;
+
+    // drivers started on its lead time, before the sample round (bit N is SENSOR_DRIVER N)
+    uint32_t drivers_started = 0;
+
+    // BME680 split-phase read
+    uint32_t bme680_end = 0;     // end of the running conversion, 0 is idle
+    bool bme680_ready = false;   // conversion collected, not published
+
+    bool dht_ready = false;      // DHT sample polled, not published
+
+    // driver health and exponential backoff
+    bool driver_backoff = true;
+    DriverHealth driver_health[SOURCES_MAX] = {};
+
+    // I2C clock and bus time budget
+#define X(driver, name, device, units, address, alt, khz, period, lead, init, start, read) khz,
+    uint16_t i2c_clock[DRIVERS_MAX] = { SENSOR_DRIVERS };  // max clock of each driver (kHz)
+#undef X
+    uint32_t i2c_clock_applied = I2C_CLOCK_DEFAULT;
+    uint32_t i2c_bus_budget = 0;            // max bus time for each round (us), 0 is disabled
+    uint32_t i2c_bus_used = 0;              // bus time on the current round (us)
+    uint32_t i2c_bus_usage = 0;             // bus time of the last round (us)
+    uint32_t i2c_bus_deferred = 0;          // sources deferred to the next round (bit N is source N)
+    uint32_t driver_bus_time[SOURCES_MAX] = {};  // EWMA of the read time of each source (us)
+
+    // extra I2C buses, multiplexers and sensor instances
+    TwoWire *i2c_buses[I2C_BUS_MAX];
+    uint8_t i2c_buses_count = 0;
+    I2CMux i2c_muxes[I2C_MUX_MAX];
+    uint8_t i2c_muxes_count = 0;
+    int8_t mux_selected = -1;          // mux with a channel open, -1 none
+    int8_t mux_channel_selected = -1;
+    SensorInstance sources[SOURCES_MAX];  // drivers (main sensors), instances, then extra UART sensors
+    uint8_t instances_count = 0;
+    char source_names[SOURCES_MAX - DRIVERS_MAX][INSTANCE_UNITS_MAX][INSTANCE_NAME_MAX];  // runtime unit names
+
+    // per source readings table (temperature and humidity)
+    FUSION_MODE th_fusion = FUSION_LAST;
+    svalue_t source_temp[SOURCES_MAX] = {};
+    svalue_t source_humi[SOURCES_MAX] = {};
+    uint16_t source_weight[SOURCES_MAX] = {};
+    uint32_t source_weight_set = 0;  // weights set with setSourceWeight, the others are SOURCE_WEIGHT_ONE
+    uint32_t source_temp_time[SOURCES_MAX] = {};  // millis() of the last sample of each source
+    uint32_t source_humi_time[SOURCES_MAX] = {};
+    uint32_t source_temp_mask = 0;  // bit N is source N, sources with a sample
+    uint32_t source_humi_mask = 0;
+
+    // measurement profile
+    MEASURE_PROFILE measure_profile = PROFILE_DEFAULT;
+
+    // live barometric CO2 compensation
+    bool co2_live_pressure = false;
+    svalue_t pres_smoothed = 0;    // hPa
+    svalue_t pres_pushed = 0;      // last pressure sent to SCD30/SCD4x (hPa)
+    uint32_t pres_push_time = 0;
+
+    // PM humidity correction, table of 1/growth factor in Q15 for each %RH
+    bool pm_humi_correction = false;
+    uint16_t pm_humi_lut[PM_LUT_RH_MAX + 1];
+
+    // detection cache
+    bool detection_cache = false;
+    uint32_t drivers_detected = 0;  // bit N is SENSOR_DRIVER N
+    bool uart_detected = false;     // main UART sensor found on its serial port
+    SENSOR_DRIVER main_driver = DRIVER_UART;  // driver of the main device (device_selected)
+    uint32_t uart_baud = 0;
+    uint32_t uart_config = SERIAL_8N1;
+
+    // baud rate and framing detection
+    bool uart_autobaud = false;
+
+    // extra UART sensors
+    UARTSlot uart_slots[UART_SLOTS_MAX];
+    uint8_t uart_slots_count = 0;
+
+    // main UART sensor stream receive (PM sensors), after its detection
+    UARTSlot uart_main;
+    bool uart_main_stream = false;
+    HardwareSerial *uart_hw_serial = nullptr;  // ESP32 UART of the main sensor
     
     uint16_t pm1;   // PM1
     uint16_t pm25;  // PM2.5
     uint16_t pm4;   // PM4
     uint16_t pm10;  // PM10
 
-    float humi = 0.0;   // % Relative humidity
-    float temp = 0.0;   // Temperature (°C)
-    float pres = 0.0;   // Pressure
-    float alt = 0.0;
-    float gas = 0.0;
+    uint16_t pm1c;   // PM1 humidity corrected
+    uint16_t pm25c;  // PM2.5 humidity corrected
+    uint16_t pm4c;   // PM4 humidity corrected
+    uint16_t pm10c;  // PM10 humidity corrected
+
+    uint16_t pm1a = 0;   // PM1 atmospheric environment (Plantower)
+    uint16_t pm25a = 0;  // PM2.5 atmospheric environment
+    uint16_t pm10a = 0;  // PM10 atmospheric environment
+
+    uint16_t cnt03 = 0;  // particles > 0.3um in 0.1L of air (Plantower)
+    uint16_t cnt05 = 0;  // particles > 0.5um
+    uint16_t cnt1 = 0;   // particles > 1.0um
+    uint16_t cnt25 = 0;  // particles > 2.5um
+    uint16_t cnt5 = 0;   // particles > 5.0um
+    uint16_t cnt10 = 0;  // particles > 10um
+
+    svalue_t npm05 = 0;  // number concentration PM0.5 (#/cm3, SPS30)
+    svalue_t npm1 = 0;   // number concentration PM1
+    svalue_t npm25 = 0;  // number concentration PM2.5
+    svalue_t npm4 = 0;   // number concentration PM4
+    svalue_t npm10 = 0;  // number concentration PM10
+    svalue_t psize = 0;  // typical particle size (um)
+
+    bool sps30_mass_only = false;
+
+    svalue_t humi = 0;   // % Relative humidity
+    svalue_t temp = 0;   // Temperature (°C)
+    svalue_t pres = 0;   // Pressure
+    svalue_t alt = 0;
+    svalue_t gas = 0;
     
-    uint16_t CO2Val;      // CO2 in ppm
-    float CO2humi = 0.0;  // humidity of CO2 sensor
-    float CO2temp = 0.0;  // temperature of CO2 sensor
+    uint16_t CO2Val;        // CO2 in ppm
+    svalue_t CO2humi = 0;  // humidity of CO2 sensor
+    svalue_t CO2temp = 0;  // temperature of CO2 sensor
 
-    void am2320Init();
+    bool am2320Init();
     void am2320Read();
 
-    void bme280Init();
-    void bme280Read();
+    bool bme280Init(SensorInstance &instance);
+    void bme280Read(SensorInstance &instance);
 
-    void bmp280Init();
+    bool bmp280Init();
     void bmp280Read();
 
-    void bme680Init();
+    bool bme680Init();
     void bme680Read();
-
-    void aht10Init();
+    bool bme680Start();
+    void bme680Collect();
+    void profileApply(SensorInstance &instance);
+    bool sht31ReadLowRep(SensorInstance &instance, float *temperature, float *humidity);
+    uint16_t scd4xMeasurementStart(SensorInstance &instance);
+    uint8_t scd4xProfileMode(SensorInstance &instance);
+    uint8_t scd4xVariant(SensorInstance &instance);
+    uint16_t scd4xCommand(SensorInstance &instance, uint16_t command);
+
+    bool aht10Init();
     void aht10Read();
 
-    void sht31Init();
-    void sht31Read();
+    bool sht31Init(SensorInstance &instance);
+    void sht31Read(SensorInstance &instance);
 
-    void CO2scd30Init();
-    void CO2scd30Read();
+    bool CO2scd30Init(SensorInstance &instance);
+    void CO2scd30Read(SensorInstance &instance);
     void setSCD30TempOffset(float offset);
     void setSCD30AltitudeOffset(float offset);
-    void CO2correctionAlt();
+    void CO2Process(uint16_t co2, bool compensate);
+    void co2TempOffsetApply();
+    CalibrationStage *getCalibrationStage(UNIT unit);
+    HampelStage *getHampelStage(UNIT unit);
+    bool isCO2Compensated();
+    void pressureUpdate(svalue_t hpa);
+    void CO2PressurePush();
     float hpaCalculation(float altitude);
 
-    void CO2scd4xInit();
-    void CO2scd4xRead();
+    bool CO2scd4xInit(SensorInstance &instance);
+    void CO2scd4xRead(SensorInstance &instance);
     void setSCD4xTempOffset(float offset);
     void setSCD4xAltitudeOffset(float offset);
 
-    void PMGCJA5Init();
+    bool PMGCJA5Init();
     void PMGCJA5Read();
 
-    void dhtInit();
+    bool dhtInit();
+    bool dhtStart();
     void dhtRead();
     bool dhtIsReady(float *temperature, float *humidity);
 
     // UART sensors methods:
 
     bool sensorSerialInit(int pms_type, int rx, int tx);
+    bool sensorSerialCachedInit(SensorsCache *cache);
+    bool waitSerialData(unsigned int lenght_buffer, uint32_t timeout);
     bool pmSensorAutoDetect(int pms_type);
+    int uartFastDetect();
+    bool uartFastDetectInit();
+    bool uartSensorSelect(int type);
+    static const char *uartDeviceName(int type);
+    bool sensorSerialProbe(int pms_type, int pms_rx, int pms_tx);
+    bool uartAutoBaud(int pms_type, int pms_rx, int pms_tx);
+    int uartTypeFromFrame(FRAME_TYPE frame);
     bool pmSensorRead();
     bool pmGenericRead();
     bool pmPanasonicRead();
     
     bool pmSDS011Read();
+    void sds011SetWorkMode(bool work);
     bool CO2Mhz19Read();
     bool CO2CM1106Read();
     int CO2CM1106val();
@@ -360,6 +1071,22 @@ class Sensors {
 
     bool serialInit(int pms_type, unsigned long speed_baud, int pms_rx, int pms_tx);
     String hwSerialRead(unsigned int lenght_buffer);
+    FRAME_TYPE uartFrameType(int type);
+    void uartSlotsService();
+    bool uartFramePoll(FRAME_TYPE type, unsigned int length, const char *name);
+    bool uartSlotInit(SensorInstance &instance);
+    bool uartSlotRead(SensorInstance &instance);
+    void uartReceive(UARTSlot *slot);
+    bool uartSlotPublish(UARTSlot *slot);
+    void uartMainStreamInit();
+
+    /// the frames of this slot are received on the serial events (receive callback)
+    template <typename T>
+    void uartEventsAttach(T *serial, UARTSlot *slot) {
+        slot->events = true;
+        serial->onReceive([this, slot]() { uartReceive(slot); });
+    }
+    bool uartFrameDecode(FRAME_TYPE type, const uint8_t *frame, uint8_t length);
     void restart();  // restart serial (it isn't works sometimes)
     void DEBUG(const char *text, const char *textb = "");
 
@@ -373,7 +1100,179 @@ class Sensors {
 
     void resetAllVariables();
 
-    uint8_t * getUnitsRegistered();
+    // driver table: built-in drivers (constant) and external drivers (static registration)
+    static const DriverOps builtin_drivers[DRIVER_COUNT];
+    static const DriverOps uart_slot_driver;  // extra UART sensors
+    static const DriverOps *external_drivers[SENSORLIB_EXTERNAL_DRIVERS];
+    static uint8_t external_drivers_count;
+
+    template <void (Sensors::*F)()>
+    static bool driverThunk(Sensors &sensors, SensorInstance &instance) {
+        (sensors.*F)();
+        return true;
+    }
+
+    template <bool (Sensors::*F)()>
+    static bool driverThunk(Sensors &sensors, SensorInstance &instance) {
+        return (sensors.*F)();
+    }
+
+    /// drivers with instances, on its context (bus, address and driver object)
+    template <void (Sensors::*F)(SensorInstance &)>
+    static bool driverThunk(Sensors &sensors, SensorInstance &instance) {
+        (sensors.*F)(instance);
+        return true;
+    }
+
+    template <bool (Sensors::*F)(SensorInstance &)>
+    static bool driverThunk(Sensors &sensors, SensorInstance &instance) {
+        return (sensors.*F)(instance);
+    }
+
+    /// I2C acknowledge of the driver address or its alternative (see SENSOR_DRIVERS) on the source bus
+    template <uint8_t A, uint8_t B>
+    static bool driverProbe(Sensors &sensors, SensorInstance &instance) {
+        instance.address = A;
+        if (sensors.i2cProbe(instance.bus, A)) return true;
+        if (B == 0) return false;
+        if (B == A) delay(1);  // the first probe wakes up the sensor (AM2320)
+        instance.address = B;
+        return sensors.i2cProbe(instance.bus, B);
+    }
+
+    bool driverNoStart();
+
+    const DriverOps *driverOps(SENSOR_DRIVER driver);
+
+    const char *driverName(SENSOR_DRIVER driver);
+
+    const DriverOps *sourceOps(uint8_t source);
+
+    void driverStart(uint8_t source);
+
+    void driversSchedule(uint32_t next_round);
+
+    bool uartDriverInit();
+
+    bool uartDriverStart();
+
+    void uartDriverRead();
+
+    void sps30DriverRead();
+
+    void driverInit(SENSOR_DRIVER driver);
+
+    void sourcesInit();
+
+    void sourceRead(uint8_t source);
+
+    bool isDriverDue(uint8_t source);
+
+    uint32_t driverDueTime(uint8_t source);
+
+    bool isDriverDetected(SENSOR_DRIVER driver);
+
+    bool isSourceDetected(uint8_t source);
+
+    bool isDriverRetryDue(uint8_t source);
+
+    void driverHealthUpdate(uint8_t source, bool success);
+
+    bool isI2CDriver(SENSOR_DRIVER driver);
+
+    bool i2cBusAvailable(uint8_t source);
+
+    void i2cBusTimeUpdate(uint8_t source, uint32_t elapsed);
+
+    void i2cClockApply();
+
+    void i2cMuxSelect(int8_t mux, int8_t channel);
+
+    void i2cMuxRelease();
+
+    bool i2cProbe(TwoWire *bus, uint8_t address);
+
+    void instancesInit();
+
+    void instancesDetect(TwoWire *bus, int8_t mux, int8_t channel);
+
+    bool instanceDeviceNew(SensorInstance &instance);
+
+    void instanceDeviceDelete(SensorInstance &instance);
+
+    void sourceUnitsRegister(uint8_t source);
+
+    const UNIT *sourceUnits(uint8_t source);
+
+    UNIT sourceUnit(uint8_t source, UNIT unit);
+
+    void driverUnitsRestore(uint8_t source);
+
+    void driverUnitsKeep();
+
+    void adaptiveUpdate(uint8_t source);
+
+    svalue_t unitProcess(UNIT unit, svalue_t value);
+
+    void unitStore(UNIT unit, svalue_t value);
+
+    /**
+     * One reading of the current source. The main sensors are processed by
+     * the pipeline of the unit, the instances and extra UART sensors by its
+     * stateless pass (without filters) to its own runtime unit (see
+     * getInstanceUnit and getUARTSensorUnit).
+     */
+    template <UNIT U, typename T>
+    void unitPublish(T reading) {
+        if (current_source < DRIVERS_MAX || current_source >= SOURCES_MAX) {
+            unitStore(U, processUnit<U>(reading));
+            unitRegister(U);
+            return;
+        }
+        UNIT unit = sourceUnit(current_source, U);
+        if (unit == NUNIT) return;
+        svalue_t value = UnitPipelineStorage<U>::pipeline.processStateless(toSValue(reading));
+        if (U == TEMP) setSourceTemperature(value);  // instances are sources of the fusion
+        if (U == HUM) setSourceHumidity(value);
+        unitStore(unit, value);
+        unitRegister(unit);
+    }
+
+    void setSourceTemperature(svalue_t temperature);
+
+    void setSourceHumidity(svalue_t humidity);
+
+    bool isSourceFresh(int source, uint32_t time);
+
+    bool sourcesFusion(svalue_t *values, uint32_t *times, uint32_t mask, svalue_t *fused);
+
+    void thFusion();
+
+    void pmHumidityCorrection();
+
+    UNIT getDriverPrimaryUnit(uint8_t source);
+
+    uint16_t *getUnitsRegistered();
+
+    const UnitDescriptor *unitDescriptor(UNIT unit);
+
+    bool loadDetectionCache(SensorsCache *cache);
+
+    void saveDetectionCache(int pms_type, int pms_rx, int pms_tx, bool uart_detected);
+
+    uint8_t detectionCacheChecksum(SensorsCache *cache);
+
+    svalue_t getUnitSValue(UNIT unit);
+
+    const char *unitName(UNIT unit);
+
+    void unitsValueRegister();
+
+    bool isUnitChanged(UNIT unit);
+
+    void unitsSnapshot();
+
+    void checkChangedUnits();
 
 // @todo use DEBUG_ESP_PORT ?
 #ifdef WM_DEBUG_PORT
@@ -383,6 +1282,53 @@ class Sensors {
 #endif
 };
 
+/**
+ * Base of external sensor drivers (CRTP), without editing the library:
+ *
+ * struct MyDriver : SensorDriver<MyDriver> {
+ *     static constexpr const char *name = "MYSENSOR";
+ *     static constexpr uint8_t address = 0x40;  // optional I2C probe
+ *     static bool init(Sensors &sensors);
+ *     static bool collect(Sensors &sensors);     // sensors.setUnitValue(UNIT::TEMP, value)
+ * };
+ * SENSORLIB_DRIVER(MyDriver);
+ *
+ * device, unit, units, period, lead, probe and start are optional.
+ */
+template <typename D>
+struct SensorDriver {
+    static constexpr const char *device = nullptr;
+    static constexpr UNIT unit = NUNIT;
+    static constexpr const UNIT *units = nullptr;
+    static constexpr uint8_t address = 0;
+    static constexpr uint16_t period = 0;
+    static constexpr uint16_t lead = 0;
+
+    /// I2C acknowledge of its address
+    static bool probe(Sensors &sensors) {
+        if (D::address == 0) return true;
+        Wire.beginTransmission(D::address);
+        return Wire.endTransmission() == 0;
+    }
+
+    static bool start(Sensors &sensors) { return true; }
+
+    // external drivers have only the main sensor, on the main bus
+    static bool probeOp(Sensors &sensors, SensorInstance &instance) { return D::probe(sensors); }
+    static bool initOp(Sensors &sensors, SensorInstance &instance) { return D::init(sensors); }
+    static bool startOp(Sensors &sensors, SensorInstance &instance) { return D::start(sensors); }
+    static bool collectOp(Sensors &sensors, SensorInstance &instance) { return D::collect(sensors); }
+
+    static const DriverOps ops;
+};
+
+template <typename D>
+const DriverOps SensorDriver<D>::ops = {D::name, D::device, D::unit, D::units, D::address, D::period,
+                                       D::lead, &probeOp, &initOp, &startOp, &collectOp};
+
+// static registration of one external driver, before setup()
+#define SENSORLIB_DRIVER(D) static const bool D##_registered = Sensors::registerDriver(&SensorDriver<D>::ops)
+
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SENSORSHANDLER)
 extern Sensors sensors;
 #endif
@@ -0,0 +1,55 @@
+#include "UARTReceiver.hpp"
+
+// UART frames lock, the receive could run on the UART event task (or host reader thread)
+#ifdef ARDUINO_ARCH_ESP32
+static portMUX_TYPE uart_mux = portMUX_INITIALIZER_UNLOCKED;
+#define UART_LOCK() portENTER_CRITICAL(&uart_mux)
+#define UART_UNLOCK() portEXIT_CRITICAL(&uart_mux)
+#elif defined(__linux__) && !defined(ARDUINO)
+#include <mutex>
+static std::mutex uart_mutex;
+#define UART_LOCK() uart_mutex.lock()
+#define UART_UNLOCK() uart_mutex.unlock()
+#else
+#define UART_LOCK() noInterrupts()
+#define UART_UNLOCK() interrupts()
+#endif
+
+void uartSlotBegin(UARTSlot *slot, Stream *serial, int type, FRAME_TYPE frame) {
+    slot->serial = serial;
+    slot->type = type;
+    slot->matcher = FrameMatcher(frame);
+    slot->length = 0;
+    slot->timestamp = 0;
+    slot->events = false;
+}
+
+/**
+ * Frame decoder of one UART sensor, the bytes available are pushed as they
+ * arrive. It runs on loop() or on the UART events (receive callback).
+ * @param callback optional, called on each valid frame
+ */
+void uartSlotReceive(UARTSlot *slot, frameCbFn callback) {
+    while (slot->serial->available() > 0) {
+        if (!slot->matcher.push(slot->serial->read())) continue;
+        UART_LOCK();
+        memcpy(slot->frame, slot->matcher.frame(), slot->matcher.length());
+        slot->length = slot->matcher.length();
+        slot->timestamp = millis();
+        UART_UNLOCK();
+        if (callback != nullptr) callback(slot->type, slot->matcher.frame(), slot->matcher.length());
+    }
+}
+
+/**
+ * Last frame received, only once.
+ * @return its length, 0 without a new frame
+ */
+uint8_t uartSlotTake(UARTSlot *slot, uint8_t *frame) {
+    UART_LOCK();
+    uint8_t length = slot->length;
+    memcpy(frame, slot->frame, length);
+    slot->length = 0;
+    UART_UNLOCK();
+    return length;
+}
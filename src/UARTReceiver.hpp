@@ -0,0 +1,32 @@
+#ifndef UARTReceiver_hpp
+#define UARTReceiver_hpp
+
+#include <Arduino.h>
+#include "SensorFrames.hpp"
+
+// Callback on each valid UART frame: sensor type (UART_SENSOR_TYPE), frame and its length
+typedef void (*frameCbFn)(int type, const uint8_t *frame, uint8_t length);
+
+/**
+ * UART sensor with its own port and decoder state. The bytes are pushed to
+ * the frame matcher as they are available (without waits), and the last
+ * valid frame is taken on each sample round. It is the receive core of the
+ * library without sensor drivers, also built on host (see test/).
+ */
+typedef struct UARTSlot {
+    Stream *serial;
+    int type;                          // UART_SENSOR_TYPE
+    FrameMatcher matcher;              // decoder state
+    uint8_t frame[FRAME_MAX_LENGTH];   // last valid frame
+    uint8_t length;                    // length of the last frame, 0 if it was taken
+    uint32_t timestamp;                // millis() of the last valid frame
+    bool events;                       // it is received on UART events, without polling
+} UARTSlot;
+
+void uartSlotBegin(UARTSlot *slot, Stream *serial, int type, FRAME_TYPE frame);
+
+void uartSlotReceive(UARTSlot *slot, frameCbFn callback);
+
+uint8_t uartSlotTake(UARTSlot *slot, uint8_t *frame);
+
+#endif
@@ -0,0 +1,321 @@
+#ifndef UnitPipeline_hpp
+#define UnitPipeline_hpp
+
+#include <Arduino.h>
+#include <type_traits>
+
+/***************************************************************
+* U N I T   V A L U E S   R E P R E S E N T A T I O N
+*
+* Default is float. With the build flag SENSORLIB_FIXED_POINT the
+* values are int32 scaled by SVALUE_SCALE (hundredths, 21.37 °C is
+* 2137) and offsets, compensations and statistics run in integer
+* math, for targets without FPU (ESP8266).
+***************************************************************/
+
+#ifdef SENSORLIB_FIXED_POINT
+typedef int32_t svalue_t;
+typedef int64_t saccum_t;  // accumulator for products and variances
+#define SVALUE_SCALE 100
+#else
+typedef float svalue_t;
+typedef float saccum_t;
+#define SVALUE_SCALE 1.0f
+#endif
+
+// Precise unit values are exported as int32 hundredths on both modes
+#define UNIT_VALUE_SCALE 100
+
+inline svalue_t toSValue(float value, std::false_type) {
+#ifdef SENSORLIB_FIXED_POINT
+    return (svalue_t)(value * SVALUE_SCALE + (value < 0 ? -0.5f : 0.5f));
+#else
+    return value;
+#endif
+}
+
+template <typename T>
+inline svalue_t toSValue(T value, std::true_type) {
+    return (svalue_t)value * SVALUE_SCALE;
+}
+
+/// sensor reading (integer or float) to the value representation
+template <typename T>
+inline svalue_t toSValue(T value) {
+    return toSValue(value, typename std::is_integral<T>::type());
+}
+
+inline float fromSValue(svalue_t value) {
+#ifdef SENSORLIB_FIXED_POINT
+    return value / (float)SVALUE_SCALE;
+#else
+    return value;
+#endif
+}
+
+/// value in hundredths (UNIT_VALUE_SCALE), without truncation of decimals or sign
+inline int32_t toUnitScaled(svalue_t value) {
+#ifdef SENSORLIB_FIXED_POINT
+    return value * (UNIT_VALUE_SCALE / SVALUE_SCALE);
+#else
+    return (int32_t)(value * UNIT_VALUE_SCALE + (value < 0 ? -0.5f : 0.5f));
+#endif
+}
+
+/// rounded and limited to uint16 (PM and CO2 units)
+inline uint16_t toU16(svalue_t value) {
+    if (value <= 0) return 0;
+    if (value >= (svalue_t)65535 * SVALUE_SCALE) return 65535;
+#ifdef SENSORLIB_FIXED_POINT
+    return (value + SVALUE_SCALE / 2) / SVALUE_SCALE;
+#else
+    return (uint16_t)(value + 0.5f);
+#endif
+}
+
+/***************************************************************
+* U N I T   V A L U E S   P O S T - P R O C E S S I N G
+*
+* Statically composed chain of stages for each unit. Each stage has
+* an inline process() method and its own parameters, the chain is
+* resolved at compile time: without virtual calls or allocation.
+***************************************************************/
+
+// Piecewise-linear calibration curves
+#define CALIBRATION_MAX_POINTS 8  // max breakpoints for each curve
+
+// Streaming outlier filter (Hampel)
+#define HAMPEL_WINDOW 5           // samples of the sliding window (odd)
+#define HAMPEL_SIGMAS_DEFAULT 3.0 // threshold in sigmas (1.4826 * MAD)
+
+// Offset (i.e. temperature offset): value - offset
+struct OffsetStage {
+    svalue_t offset = 0;
+    inline svalue_t process(svalue_t value) { return value - offset; }
+};
+
+// Linear calibration: gain * value + bias (float parameters)
+struct LinearStage {
+    float gain = 1.0;
+    float bias = 0.0;
+    inline svalue_t process(svalue_t value) { return toSValue(gain * fromSValue(value) + bias); }
+};
+
+// Polynomial calibration of degree N: coef[0] + coef[1] * value + ... (Horner, float)
+template <int N>
+struct PolynomialStage {
+    float coef[N + 1];
+    PolynomialStage() {
+        for (int i = 0; i <= N; i++) coef[i] = i == 1 ? 1.0 : 0.0;
+    }
+    inline svalue_t process(svalue_t value) {
+        float x = fromSValue(value);
+        float result = coef[N];
+        for (int i = N - 1; i >= 0; i--) result = result * x + coef[i];
+        return toSValue(result);
+    }
+};
+
+// Exponential moving average filter, alpha is the weight of the new value (%), 100 is disabled
+struct EwmaStage {
+    uint8_t alpha = 100;
+    svalue_t state = 0;
+    bool primed = false;
+    inline svalue_t process(svalue_t value) {
+        state = primed ? state + (saccum_t)(value - state) * alpha / 100 : value;
+        primed = true;
+        return state;
+    }
+};
+
+// Clamp to a valid range
+struct ClampStage {
+    svalue_t low = -1000000000;
+    svalue_t high = 1000000000;
+    inline svalue_t process(svalue_t value) { return value < low ? low : (value > high ? high : value); }
+};
+
+// Unit conversion: value * factor + offset (i.e. Pa to hPa, C to F)
+struct ConversionStage {
+    float factor = 1.0;
+    float offset = 0.0;
+    inline svalue_t process(svalue_t value) { return toSValue(fromSValue(value) * factor + offset); }
+};
+
+// CO2 pressure compensation, 1.6% for each 10 hPa of difference at sea level. 0 hPa is disabled
+struct CO2PressureStage {
+    svalue_t pressure = 0;  // hPa
+    inline svalue_t process(svalue_t value) {
+        if (pressure == 0) return value;
+#ifdef SENSORLIB_FIXED_POINT
+        return value + (saccum_t)16 * (101325 - pressure) * (value - 40000) / 1000000;
+#else
+        return (0.016 * ((1013.25 - pressure) / 10) * (value - 400)) + value;
+#endif
+    }
+};
+
+/**
+ * Piecewise-linear calibration curve against a reference instrument.
+ * Breakpoints are on the value representation (svalue_t): with fixed point
+ * it is evaluated with binary search and integer interpolation (without FPU
+ * on ESP8266), with float it stays on float. Values out of the curve are
+ * extrapolated with the first or last segment.
+ */
+struct CalibrationStage {
+    uint8_t points = 0;  // 0 is disabled
+    svalue_t x[CALIBRATION_MAX_POINTS];
+    svalue_t y[CALIBRATION_MAX_POINTS];
+
+    inline svalue_t process(svalue_t value) {
+        if (points == 0) return value;
+        if (points == 1) return value + y[0] - x[0];
+        uint8_t lo = 0, hi = points - 1;
+        while (hi - lo > 1) {
+            uint8_t mid = (lo + hi) / 2;
+            if (value < x[mid]) hi = mid;
+            else lo = mid;
+        }
+        return y[lo] + (svalue_t)((saccum_t)(y[hi] - y[lo]) * (value - x[lo]) / (x[hi] - x[lo]));
+    }
+};
+
+/**
+ * Streaming Hampel filter for single sample spikes (UART glitches, fan
+ * hiccups). The value is replaced by the median of the window when its
+ * deviation is more than k * 1.4826 * MAD (median absolute deviation)
+ * and more than min_deviation. The MAD is floored to one unit, PM and CO2
+ * readings are integers and a steady window (MAD 0) would flag any change.
+ * Ring buffer plus sorted window: constant memory and O(N) update.
+ * Disabled with k = 0.
+ */
+struct HampelStage {
+    uint16_t k = 0;              // threshold in hundredths of sigma, 0 is disabled
+    svalue_t min_deviation = 0;  // min deviation to flag an outlier
+    uint32_t outliers = 0;       // outliers replaced
+    bool outlier = false;        // last value was replaced
+    svalue_t ring[HAMPEL_WINDOW];
+    svalue_t sorted[HAMPEL_WINDOW];
+    uint8_t count = 0;
+    uint8_t head = 0;
+
+    void push(svalue_t value) {
+        uint8_t n = count;
+        if (count == HAMPEL_WINDOW) {  // remove the oldest value of the sorted window
+            uint8_t i = 0;
+            while (i < n - 1 && sorted[i] != ring[head]) i++;
+            for (; i < n - 1; i++) sorted[i] = sorted[i + 1];
+            n--;
+        } else
+            count++;
+        uint8_t j = n;
+        for (; j > 0 && sorted[j - 1] > value; j--) sorted[j] = sorted[j - 1];
+        sorted[j] = value;
+        ring[head] = value;
+        head = (head + 1) % HAMPEL_WINDOW;
+    }
+
+    inline svalue_t process(svalue_t value) {
+        outlier = false;
+        if (k == 0) return value;
+        push(value);
+        if (count < HAMPEL_WINDOW) return value;
+        svalue_t median = sorted[HAMPEL_WINDOW / 2];
+        svalue_t dev[HAMPEL_WINDOW];
+        for (uint8_t i = 0; i < HAMPEL_WINDOW; i++) {
+            svalue_t d = sorted[i] > median ? sorted[i] - median : median - sorted[i];
+            uint8_t j = i;
+            for (; j > 0 && dev[j - 1] > d; j--) dev[j] = dev[j - 1];
+            dev[j] = d;
+        }
+        svalue_t mad = dev[HAMPEL_WINDOW / 2] < SVALUE_SCALE ? SVALUE_SCALE : dev[HAMPEL_WINDOW / 2];
+        svalue_t diff = value > median ? value - median : median - value;
+        if (diff <= min_deviation || (saccum_t)diff * 1000000 <= (saccum_t)k * 14826 * mad) return value;
+        outlier = true;
+        outliers++;
+        return median;
+    }
+};
+
+template <typename S>
+struct StageTag {};
+
+template <typename... Stages>
+class Pipeline;
+
+/**
+ * Stateless pass of one stage, for the readings of other sources of the
+ * same unit (sensor instances): the stages with state of the main sensor
+ * (filters) are skipped, calibrations and offsets are applied.
+ */
+template <typename S>
+inline svalue_t stageStateless(S &stage, svalue_t value) { return stage.process(value); }
+
+inline svalue_t stageStateless(EwmaStage &, svalue_t value) { return value; }
+
+inline svalue_t stageStateless(HampelStage &, svalue_t value) { return value; }
+
+template <typename... Stages>
+inline svalue_t stageStateless(Pipeline<Stages...> &pipeline, svalue_t value) { return pipeline.processStateless(value); }
+
+// the pipeline P has the stage S, on it or on a nested pipeline
+template <typename P, typename S>
+struct HasStage : std::false_type {};
+
+template <typename S>
+struct HasStage<Pipeline<>, S> : std::false_type {};
+
+template <typename S, typename Head, typename... Tail>
+struct HasStage<Pipeline<Head, Tail...>, S>
+    : std::integral_constant<bool, std::is_same<Head, S>::value || HasStage<Head, S>::value ||
+                                       HasStage<Pipeline<Tail...>, S>::value> {};
+
+template <>
+class Pipeline<> {
+   public:
+    inline svalue_t process(svalue_t value) { return value; }
+
+    inline svalue_t processStateless(svalue_t value) { return value; }
+
+    template <typename S>
+    S &get(StageTag<S>) {
+        static_assert(sizeof(S) == 0, "stage not found on the pipeline");
+        return *(S *)nullptr;
+    }
+};
+
+/**
+ * Pipeline of stages, it is a stage too (pipelines could be nested).
+ * Stages are accessed by type with stage<T>(), the first one of this type,
+ * also inside of nested pipelines (i.e. the UserStages of a unit).
+ */
+template <typename Head, typename... Tail>
+class Pipeline<Head, Tail...> {
+   public:
+    Head head;
+    Pipeline<Tail...> tail;
+
+    inline svalue_t process(svalue_t value) { return tail.process(head.process(value)); }
+
+    inline svalue_t processStateless(svalue_t value) { return tail.processStateless(stageStateless(head, value)); }
+
+    template <typename S>
+    S &stage() { return get(StageTag<S>()); }
+
+    template <typename S>
+    S &get(StageTag<S> tag) {
+        return find(tag, std::integral_constant<int, std::is_same<Head, S>::value ? 0 : HasStage<Head, S>::value ? 1 : 2>());
+    }
+
+   private:
+    template <typename S>
+    S &find(StageTag<S>, std::integral_constant<int, 0>) { return head; }
+
+    template <typename S>
+    S &find(StageTag<S> tag, std::integral_constant<int, 1>) { return head.get(tag); }
+
+    template <typename S>
+    S &find(StageTag<S> tag, std::integral_constant<int, 2>) { return tail.get(tag); }
+};
+
+#endif
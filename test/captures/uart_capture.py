@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""
+UART line captures of the sensors for the host tests of the frame matchers
+and the baud rate and framing detection (uartAutoBaud).
+
+Each sensor frame is rendered on the line at the sensor baud rate and
+framing, and it is sampled with the receiver of each detection candidate
+(9600 8N1, 9600 8E1 and 115200 8N1) like a Linux tty in raw mode: bytes
+with framing or parity errors are read as 0x00. The probe commands of the
+detection are sampled by the sensor too, a sensor only answers when it
+receives its command without errors. Up to 128 bytes are recorded on each
+candidate (UART_SNIFF_BUFFER).
+
+Usage: python3 uart_capture.py [output dir]
+"""
+import os
+import sys
+
+SNIFF_BUFFER = 128
+SNIFF_WINDOW = 1.1  # seconds
+CANDIDATES = [(9600, 'N'), (9600, 'E'), (115200, 'N')]
+
+MHZ19_READ = bytes([0xFF, 0x01, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x79])
+CM1106_READ = bytes([0x11, 0x01, 0x01, 0xED])
+S8_READ = bytes([0xFE, 0x04, 0x00, 0x03, 0x00, 0x01, 0xD5, 0xC5])
+SHDLC_INFO = bytes([0x7E, 0x00, 0xD0, 0x01, 0x00, 0x2E, 0x7E])
+
+
+def line(frames, baud, parity):
+    """Line levels as (time, level) edges. frames: [(start time, bytes)]"""
+    edges = [(0.0, 1)]
+    bit = 1.0 / baud
+    for start, data in frames:
+        t = max(start, edges[-1][0])
+        for b in data:
+            bits = [0] + [(b >> i) & 1 for i in range(8)]
+            if parity == 'E':
+                bits.append(bin(b).count('1') & 1)
+            bits.append(1)
+            for level in bits:
+                edges.append((t, level))
+                t += bit
+        edges.append((t, 1))
+    return edges
+
+
+def level(edges, t):
+    lo, hi = 0, len(edges) - 1
+    while lo < hi:
+        mid = (lo + hi + 1) // 2
+        if edges[mid][0] <= t:
+            lo = mid
+        else:
+            hi = mid - 1
+    return edges[lo][1]
+
+
+def sample(edges, baud, parity, t0=0.0, t1=None, limit=None):
+    """Receiver of a Linux tty: bytes with framing or parity errors are 0x00"""
+    bit = 1.0 / baud
+    end = edges[-1][0] + bit if t1 is None else t1
+    out = []
+    t = t0
+    step = bit / 16  # receiver oversampling
+    while t < end and (limit is None or len(out) < limit):
+        if level(edges, t) == 1 or level(edges, t - step) == 0:
+            t += step
+            continue
+        if level(edges, t + bit / 2) != 0:  # false start bit
+            t += step
+            continue
+        value = 0
+        for i in range(8):
+            value |= level(edges, t + bit * (1.5 + i)) << i
+        pos = 9.5
+        error = False
+        if parity == 'E':
+            error = level(edges, t + bit * pos) != bin(value).count('1') & 1
+            pos += 1
+        if level(edges, t + bit * pos) != 1:
+            error = True
+        out.append((t, 0 if error else value))
+        t += bit * pos
+    return out
+
+
+def pms_frame(pm1, pm25, pm10, version=0x97):
+    words = [0x424D, 28, pm1, pm25, pm10, pm1, pm25, pm10, 1200, 380, 60, 8, 2, 1, version << 8]
+    data = b''.join(w.to_bytes(2, 'big') for w in words)
+    return data + (sum(data) & 0xFFFF).to_bytes(2, 'big')
+
+
+def gcja5_frame(pm1, pm25, pm10):
+    body = bytearray(29)
+    for i, v in enumerate((pm1, pm25, pm10)):
+        body[i * 4:i * 4 + 4] = v.to_bytes(4, 'little')
+    fcc = 0
+    for b in body:
+        fcc ^= b
+    return bytes([0x02]) + bytes(body) + bytes([fcc, 0x03])
+
+
+def modbus_crc(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def s8_response(co2):
+    data = bytes([0xFE, 0x04, 0x02]) + co2.to_bytes(2, 'big')
+    return data + modbus_crc(data).to_bytes(2, 'little')
+
+
+def shdlc_frame(addr, cmd, state, data):
+    content = bytes([addr, cmd, state, len(data)]) + data
+    content += bytes([~sum(content) & 0xFF])
+    stuffed = bytearray()
+    for b in content:
+        if b in (0x7E, 0x7D, 0x11, 0x13):
+            stuffed += bytes([0x7D, b ^ 0x20])
+        else:
+            stuffed.append(b)
+    return bytes([0x7E]) + bytes(stuffed) + bytes([0x7E])
+
+
+class Streaming:
+    """Sensor sending frames periodically (Plantower, Panasonic)"""
+
+    def __init__(self, frames, period, baud, parity):
+        self.frames, self.period, self.baud, self.parity = frames, period, baud, parity
+
+    def output(self, probes):
+        return [(0.05 + i * self.period, f) for i, f in enumerate(self.frames)]
+
+
+class Polled:
+    """Sensor answering to its command (SenseAir S8, SPS30)"""
+
+    def __init__(self, command, response, baud, parity, latency=0.01):
+        self.command, self.response = command, response
+        self.baud, self.parity, self.latency = baud, parity, latency
+
+    def output(self, probes):
+        frames = []
+        for start, data, baud, parity in probes:
+            edges = line([(start, data)], baud, parity)
+            received = bytes(b for _, b in sample(edges, self.baud, self.parity))
+            if self.command in received:
+                frames.append((edges[-1][0] + self.latency, self.response))
+        return frames
+
+
+def capture(sensor, baud, parity):
+    if baud == 115200:
+        probes = [(0.0, SHDLC_INFO, baud, parity)]
+    else:
+        probes = [(0.0, MHZ19_READ, baud, parity), (0.02, CM1106_READ, baud, parity), (0.04, S8_READ, baud, parity)]
+    edges = line(sensor.output(probes), sensor.baud, sensor.parity)
+    return bytes(b for _, b in sample(edges, baud, parity, t1=SNIFF_WINDOW, limit=SNIFF_BUFFER))
+
+
+SENSORS = {
+    'pms7003': Streaming([pms_frame(9, 14, 17), pms_frame(10, 15, 18), pms_frame(10, 15, 19), pms_frame(11, 16, 19)],
+                         0.25, 9600, 'N'),
+    'gcja5': Streaming([gcja5_frame(7, 12, 21)], 1.0, 9600, 'E'),
+    's8': Polled(S8_READ, s8_response(612), 9600, 'N'),
+    'sps30': Polled(SHDLC_INFO, shdlc_frame(0x00, 0xD0, 0x00, b'00080000\x00'), 115200, 'N'),
+}
+
+
+def main():
+    out = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    for name, sensor in SENSORS.items():
+        for baud, parity in CANDIDATES:
+            path = os.path.join(out, '%s_%d_8%s1.bin' % (name, baud, parity.lower()))
+            with open(path, 'wb') as f:
+                f.write(capture(sensor, baud, parity))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,41 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+/**
+ * Arduino shim for the host tests (Linux): Stream and millis() for the UART
+ * receive core (UARTReceiver) and PtySerial, without the Arduino toolchain
+ * and the sensor drivers.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+inline unsigned long millis() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000UL + now.tv_nsec / 1000000UL;
+}
+
+class Print {
+   public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+   public:
+    virtual int available() = 0;
+
+    virtual int read() = 0;
+
+    virtual int peek() = 0;
+};
+
+#endif
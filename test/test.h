@@ -0,0 +1,50 @@
+#ifndef test_h
+#define test_h
+
+/**
+ * Minimal checks for the host tests (Linux), without dependencies. A failed
+ * check is printed and the test exits with error at the end.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);   \
+            test_failures++;                                                  \
+        }                                                                     \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                       \
+    do {                                                                                     \
+        long long _a = (long long)(a), _b = (long long)(b);                                  \
+        if (_a != _b) {                                                                      \
+            printf("%s:%d: %s == %s failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+            test_failures++;                                                                 \
+        }                                                                                    \
+    } while (0)
+
+#define TEST_RESULT(name)                                                     \
+    (printf("%s: %s\n", name, test_failures == 0 ? "OK" : "FAILED"), test_failures == 0 ? 0 : 1)
+
+/// line capture of test/captures (see uart_capture.py), returns the bytes read
+static size_t readCapture(const char *name, uint8_t *buf, size_t size) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s%s.bin", CAPTURES_DIR, name);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("capture not found: %s\n", path);
+        test_failures++;
+        return 0;
+    }
+    size_t len = fread(buf, 1, size, file);
+    fclose(file);
+    return len;
+}
+
+#endif
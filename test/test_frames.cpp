@@ -0,0 +1,270 @@
+/**
+ * Host tests of the UART frame matchers, the frame decoder and the scorer of
+ * the baud rate and framing detection, over line captures of 9600 8N1, 9600
+ * 8E1 and 115200 8N1 (see captures/uart_capture.py).
+ */
+#include "SensorFrames.hpp"
+#include "test.h"
+
+// candidates of uartAutoBaud(), in the same order
+static const char *const candidates[] = {"9600_8n1", "9600_8e1", "115200_8n1"};
+
+/// all valid frames of a capture
+static int matchAll(const uint8_t *data, size_t len, FrameMatcher *matcher) {
+    int frames = 0;
+    for (size_t i = 0; i < len; i++) frames += matcher->push(data[i]);
+    return frames;
+}
+
+/// candidate chosen by the detection: the first one with the highest score
+static int sniffBest(const char *sensor, FRAME_TYPE *frame) {
+    int best = -1, best_score = 0;
+    *frame = FRAME_NONE;
+    for (int i = 0; i < 3; i++) {
+        char name[64];
+        uint8_t buf[256];
+        snprintf(name, sizeof(name), "%s_%s", sensor, candidates[i]);
+        size_t len = readCapture(name, buf, sizeof(buf));
+        FRAME_TYPE type;
+        int score = frameScore(buf, len, &type);
+        if (score > best_score) {
+            best = i;
+            best_score = score;
+            *frame = type;
+        }
+    }
+    return best;
+}
+
+/// PMS3003 frame (24 bytes, length field of 20) with its checksum
+static void pms3003Frame(uint8_t *frame, uint16_t pm25, uint16_t pm10) {
+    const uint16_t words[12] = {0x424D, 20, 11, pm25, pm10, 10, pm25, pm10, 0, 0, 0, 0};
+    uint16_t sum = 0;
+    for (int i = 0; i < 12; i++) {
+        frame[i * 2] = words[i] >> 8;
+        frame[i * 2 + 1] = words[i] & 0xFF;
+        if (i < 11) sum += frame[i * 2] + frame[i * 2 + 1];
+    }
+    frame[22] = sum >> 8;
+    frame[23] = sum & 0xFF;
+}
+
+static void testPlantower() {
+    uint8_t buf[256];
+    size_t len = readCapture("pms7003_9600_8n1", buf, sizeof(buf));
+    FrameMatcher matcher(FRAME_PMS);
+    uint16_t pm25[4];
+    int frames = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!matcher.push(buf[i])) continue;
+        CHECK_EQ(matcher.length(), 32);
+        if (frames < 4) pm25[frames] = matcher.frame()[6] << 8 | matcher.frame()[7];
+        frames++;
+    }
+    CHECK_EQ(frames, 4);
+    CHECK_EQ(matcher.errors(), 0);
+    CHECK_EQ(pm25[0], 14);
+    CHECK_EQ(pm25[3], 16);
+
+    // short frames (PMS3003), the checksum is on its own length field
+    uint8_t pms3003[24];
+    pms3003Frame(pms3003, 25, 40);
+    FrameMatcher shortFrame(FRAME_PMS);
+    CHECK_EQ(matchAll(pms3003, 24, &shortFrame), 1);
+    CHECK_EQ(shortFrame.length(), 24);
+    CHECK_EQ(shortFrame.errors(), 0);
+
+    // 8E1 on a 8N1 stream: framing errors, without any frame
+    len = readCapture("pms7003_9600_8e1", buf, sizeof(buf));
+    FrameMatcher wrong(FRAME_PMS);
+    CHECK_EQ(matchAll(buf, len, &wrong), 0);
+}
+
+static void testResync() {
+    uint8_t buf[256];
+    size_t len = readCapture("pms7003_9600_8n1", buf, sizeof(buf));
+    uint8_t stream[300];
+    size_t n = 0;
+    const uint8_t noise[] = {0x42, 0x00, 0x4D, 0x42, 0x42};  // false headers before the frame
+    for (uint8_t c : noise) stream[n++] = c;
+    for (size_t i = 0; i < 32 && i < len; i++) stream[n++] = buf[i];
+    FrameMatcher matcher(FRAME_PMS);
+    CHECK_EQ(matchAll(stream, n, &matcher), 1);
+
+    // wrong checksum: header right, counted as error and not as frame
+    buf[10] ^= 0x01;
+    FrameMatcher corrupted(FRAME_PMS);
+    CHECK_EQ(matchAll(buf, 32, &corrupted), 0);
+    CHECK_EQ(corrupted.errors(), 1);
+    CHECK_EQ(frameScore(buf, 32), 0);  // without valid frames it doesn't score
+
+    // garbage with stray headers (Panasonic 0x02) isn't a candidate
+    const uint8_t garbage[] = {0x02, 0x13, 0x77, 0x02, 0x00, 0x5A, 0x02, 0x81, 0x02, 0x44, 0x02, 0x10};
+    uint8_t stray[200];
+    for (size_t i = 0; i < sizeof(stray); i++) stray[i] = garbage[i % sizeof(garbage)];
+    FRAME_TYPE type;
+    CHECK_EQ(frameScore(stray, sizeof(stray), &type), 0);
+    CHECK_EQ(type, FRAME_NONE);
+}
+
+static void testPanasonic() {
+    uint8_t buf[256];
+    size_t len = readCapture("gcja5_9600_8e1", buf, sizeof(buf));
+    FrameMatcher matcher(FRAME_PANASONIC);
+    CHECK_EQ(matchAll(buf, len, &matcher), 1);
+    CHECK_EQ(matcher.frame()[5], 12);  // PM2.5, little endian
+    CHECK_EQ(matcher.frame()[9], 21);  // PM10
+
+    // 8N1 on a 8E1 stream: bytes with the parity bit on the stop bit are lost
+    len = readCapture("gcja5_9600_8n1", buf, sizeof(buf));
+    FrameMatcher wrong(FRAME_PANASONIC);
+    CHECK_EQ(matchAll(buf, len, &wrong), 0);
+    CHECK(wrong.errors() > 0);
+}
+
+static void testSenseAirS8() {
+    uint8_t buf[256];
+    size_t len = readCapture("s8_9600_8n1", buf, sizeof(buf));
+    FrameMatcher matcher(FRAME_S8);
+    CHECK_EQ(matchAll(buf, len, &matcher), 1);
+    CHECK_EQ(matcher.length(), 7);
+    CHECK_EQ(matcher.frame()[3] << 8 | matcher.frame()[4], 612);
+    CHECK_EQ(modbusCRC(s8_read_cmd, 6), s8_read_cmd[6] | s8_read_cmd[7] << 8);
+}
+
+static void testSHDLC() {
+    uint8_t buf[256];
+    size_t len = readCapture("sps30_115200_8n1", buf, sizeof(buf));
+    FrameMatcher matcher(FRAME_SHDLC);
+    CHECK_EQ(matchAll(buf, len, &matcher), 1);
+    CHECK_EQ(matcher.length(), 14);  // address, command, state, length, 9 data bytes and checksum
+    CHECK_EQ(matcher.frame()[1], 0xD0);
+    CHECK_EQ(matcher.frame()[4], '0');
+
+    // byte stuffing: 0x7E on the data is sent as 0x7D 0x5E
+    const uint8_t stuffed[] = {0x7E, 0x00, 0x03, 0x00, 0x01, 0x7D, 0x5E, 0x7D, 0x5D, 0x7E};
+    FrameMatcher unstuff(FRAME_SHDLC);
+    CHECK_EQ(matchAll(stuffed, sizeof(stuffed), &unstuff), 1);
+    CHECK_EQ(unstuff.frame()[4], 0x7E);
+}
+
+static void testSensirionCRC() {
+    const uint8_t word[] = {0xBE, 0xEF};
+    CHECK_EQ(sensirionCRC(word, 2), 0x92);  // datasheet example
+}
+
+/// first valid frame of a capture, decoded
+static bool decodeCapture(const char *name, FRAME_TYPE type, FrameValues *values) {
+    uint8_t buf[256];
+    size_t len = readCapture(name, buf, sizeof(buf));
+    FrameMatcher matcher(type);
+    for (size_t i = 0; i < len; i++) {
+        if (matcher.push(buf[i])) return frameDecode(type, matcher.frame(), matcher.length(), values);
+    }
+    return false;
+}
+
+/// SDS011 frame with its checksum, PM in tenths
+static void sds011Frame(uint8_t *frame, uint16_t pm25, uint16_t pm10) {
+    const uint8_t data[10] = {0xAA, 0xC0, (uint8_t)pm25, (uint8_t)(pm25 >> 8), (uint8_t)pm10, (uint8_t)(pm10 >> 8), 0x12, 0x34, 0, 0xAB};
+    memcpy(frame, data, 10);
+    for (int i = 2; i < 8; i++) frame[8] += frame[i];
+}
+
+static void testDecode() {
+    FrameValues values;
+    CHECK(decodeCapture("pms7003_9600_8n1", FRAME_PMS, &values));
+    CHECK(values.has_pm && values.has_pm1 && values.has_extended && !values.has_co2);
+    CHECK_EQ(values.pm25, 14);
+
+    uint8_t pms3003[24];
+    pms3003Frame(pms3003, 25, 40);
+    CHECK(frameDecode(FRAME_PMS, pms3003, 24, &values));
+    CHECK(values.has_pm && !values.has_pm1 && !values.has_extended);
+    CHECK_EQ(values.pm25, 25);
+    CHECK_EQ(values.pm10, 40);
+
+    CHECK(decodeCapture("gcja5_9600_8e1", FRAME_PANASONIC, &values));
+    CHECK(values.has_pm1 && !values.has_extended);
+    CHECK_EQ(values.pm25, 12);
+    CHECK_EQ(values.pm10, 21);
+
+    CHECK(decodeCapture("s8_9600_8n1", FRAME_S8, &values));
+    CHECK(values.has_co2 && !values.has_pm && !values.has_temperature);
+    CHECK_EQ(values.co2, 612);
+
+    uint8_t frame[10];
+    sds011Frame(frame, 123, 456);
+    FrameMatcher matcher(FRAME_SDS011);
+    CHECK_EQ(matchAll(frame, 10, &matcher), 1);
+    CHECK(frameDecode(FRAME_SDS011, frame, 10, &values));
+    CHECK(values.has_pm && !values.has_pm1);
+    CHECK_EQ(values.pm25, 12);
+    CHECK_EQ(values.pm10, 45);
+
+    // out of range: PM2.5 and PM10 over 1000
+    sds011Frame(frame, 10010, 10010);
+    CHECK(!frameDecode(FRAME_SDS011, frame, 10, &values));
+    sds011Frame(frame, 10010, 50);
+    CHECK(frameDecode(FRAME_SDS011, frame, 10, &values));
+
+    // MH-Z19: CO2 and temperature (offset of 40), CO2 of zero on its warm up
+    uint8_t mhz19[9] = {0xFF, 0x86, 0x02, 0x58, 0x41, 0x00, 0x00, 0x00, 0x00};
+    CHECK(frameDecode(FRAME_MHZ19, mhz19, 9, &values));
+    CHECK_EQ(values.co2, 600);
+    CHECK(values.has_temperature);
+    CHECK_EQ(values.temperature, 25);
+    mhz19[2] = mhz19[3] = 0;
+    CHECK(!frameDecode(FRAME_MHZ19, mhz19, 9, &values));
+}
+
+/// concurrent detection (uartFastDetect) over the probe answers and the PM streams
+static void testFastDetect() {
+    uint8_t stream[64];
+    const uint8_t noise[] = {0x02, 0xFF, 0x42, 0xAA, 0x16};  // false headers of other sensors
+    memcpy(stream, noise, sizeof(noise));
+    pms3003Frame(stream + sizeof(noise), 25, 40);
+    FrameDetector detector;
+    FRAME_TYPE detected = FRAME_NONE;
+    for (size_t i = 0; i < sizeof(noise) + 24 && detected == FRAME_NONE; i++) detected = detector.push(stream[i]);
+    CHECK_EQ(detected, FRAME_PMS);
+
+    uint8_t buf[256];
+    size_t len = readCapture("s8_9600_8n1", buf, sizeof(buf));
+    FrameDetector co2;
+    detected = FRAME_NONE;
+    for (size_t i = 0; i < len && detected == FRAME_NONE; i++) detected = co2.push(buf[i]);
+    CHECK_EQ(detected, FRAME_S8);
+}
+
+static void testAutoBaud() {
+    FRAME_TYPE frame;
+    CHECK_EQ(sniffBest("pms7003", &frame), 0);
+    CHECK_EQ(frame, FRAME_PMS);
+    CHECK_EQ(sniffBest("gcja5", &frame), 1);
+    CHECK_EQ(frame, FRAME_PANASONIC);
+    CHECK_EQ(sniffBest("s8", &frame), 0);
+    CHECK_EQ(frame, FRAME_S8);
+    CHECK_EQ(sniffBest("sps30", &frame), 2);
+    CHECK_EQ(frame, FRAME_SHDLC);
+
+    // garbled captures of the wrong baud rates don't score
+    uint8_t buf[256];
+    size_t len = readCapture("pms7003_115200_8n1", buf, sizeof(buf));
+    CHECK_EQ(frameScore(buf, len), 0);
+    len = readCapture("gcja5_115200_8n1", buf, sizeof(buf));
+    CHECK_EQ(frameScore(buf, len), 0);
+}
+
+int main() {
+    testPlantower();
+    testResync();
+    testPanasonic();
+    testSenseAirS8();
+    testSHDLC();
+    testSensirionCRC();
+    testDecode();
+    testFastDetect();
+    testAutoBaud();
+    return TEST_RESULT("test_frames");
+}
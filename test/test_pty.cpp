@@ -0,0 +1,113 @@
+/**
+ * Host test of the UART receive on events over a Linux pseudo terminal
+ * (PtySerial): the line captures are written on the slave side like a
+ * sensor, and its frames are checked on the frame callback and decoder.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "PtySerial.hpp"
+#include "UARTReceiver.hpp"
+#include "test.h"
+
+#define PTY_TIMEOUT 2000  // max wait for the frames (ms)
+
+// last frame of the callback, it runs on the reader thread of PtySerial
+static std::atomic<int> frames_received{0};
+static int frame_type = -1;
+static uint8_t frame_length = 0;
+
+static void onFrame(int type, const uint8_t *frame, uint8_t length) {
+    (void)frame;
+    frame_type = type;
+    frame_length = length;
+    frames_received++;
+}
+
+/// capture written in small blocks (frames split between reads) on the slave side
+static void simulate(const char *slave, const char *capture) {
+    uint8_t buf[256];
+    size_t len = readCapture(capture, buf, sizeof(buf));
+    int fd = open(slave, O_WRONLY | O_NOCTTY);
+    CHECK(fd >= 0);
+    if (fd < 0) return;
+    for (size_t i = 0; i < len; i += 7) {
+        size_t block = len - i < 7 ? len - i : 7;
+        CHECK_EQ(write(fd, buf + i, block), block);
+        usleep(1000);
+    }
+    close(fd);
+}
+
+static bool waitFrames(int count) {
+    unsigned long start = millis();
+    while (frames_received < count && millis() - start < PTY_TIMEOUT) usleep(1000);
+    usleep(20000);  // no more frames than expected
+    return frames_received == count;
+}
+
+/// receive of one capture on its pty, like an extra UART sensor on events
+static void receive(const char *capture, int type, FRAME_TYPE frame, int expected, FrameValues *values) {
+    PtySerial serial;
+    CHECK(serial.begin());
+    UARTSlot slot;
+    uartSlotBegin(&slot, &serial, type, frame);
+    serial.onReceive([&slot]() { uartSlotReceive(&slot, onFrame); });
+    frames_received = 0;
+    simulate(serial.slaveName(), capture);
+    CHECK(waitFrames(expected));
+    CHECK_EQ(frames_received, expected);
+    CHECK_EQ(frame_type, type);
+    CHECK_EQ(serial.overflows(), 0);
+
+    uint8_t last[FRAME_MAX_LENGTH];
+    uint8_t length = uartSlotTake(&slot, last);
+    CHECK_EQ(length, frame_length);
+    CHECK(frameDecode(frame, last, length, values));
+    CHECK_EQ(uartSlotTake(&slot, last), 0);  // taken only once
+    serial.end();
+}
+
+static void testPlantower() {
+    FrameValues values;
+    receive("pms7003_9600_8n1", 0, FRAME_PMS, 4, &values);
+    CHECK_EQ(frame_length, 32);
+    CHECK_EQ(values.pm25, 16);  // the last frame
+    CHECK(values.has_extended);
+}
+
+static void testSenseAirS8() {
+    FrameValues values;
+    receive("s8_9600_8n1", 6, FRAME_S8, 1, &values);
+    CHECK_EQ(frame_length, 7);
+    CHECK_EQ(values.co2, 612);
+}
+
+/// CO2 request of the slot, read on the slave side
+static void testRequest() {
+    PtySerial serial;
+    CHECK(serial.begin());
+    int fd = open(serial.slaveName(), O_RDONLY | O_NOCTTY);
+    CHECK(fd >= 0);
+    CHECK_EQ(serial.write(s8_read_cmd, sizeof(s8_read_cmd)), sizeof(s8_read_cmd));
+    uint8_t buf[sizeof(s8_read_cmd)];
+    size_t len = 0;
+    unsigned long start = millis();
+    while (fd >= 0 && len < sizeof(buf) && millis() - start < PTY_TIMEOUT) {
+        ssize_t n = read(fd, buf + len, sizeof(buf) - len);
+        if (n > 0) len += n;
+    }
+    CHECK_EQ(len, sizeof(s8_read_cmd));
+    CHECK(memcmp(buf, s8_read_cmd, len) == 0);
+    if (fd >= 0) close(fd);
+    serial.end();
+}
+
+int main() {
+    testPlantower();
+    testSenseAirS8();
+    testRequest();
+    return TEST_RESULT("test_pty");
+}